@@ -0,0 +1,171 @@
+#include <cstdlib>
+#include <new>
+
+#include "Arena.hpp"
+#include "Threadpool.hpp"
+
+
+// The free chunks of the pool
+// Chunks are in size classes of power of 2 times CHUNK_SIZE, one list for each class
+struct FreeChunks
+{
+  static constexpr unsigned CLASS_CNT = 40;
+
+  std::mutex mutex;
+
+  std::vector<ChunkPool::Chunk> lists[CLASS_CNT];
+
+  size_t cached = 0;
+
+  ~FreeChunks()
+  {
+    for (auto& list : lists)
+    {
+      for (auto& chunk : list)
+        std::free(chunk.data);
+    }
+  }
+};
+
+static FreeChunks& freeChunks()
+{
+  static FreeChunks chunks;
+
+  return chunks;
+}
+
+// Size class of the bytes, the smallest class that can hold them
+static unsigned sizeClass(size_t bytes)
+{
+  unsigned c = 0;
+
+  while ((ChunkPool::CHUNK_SIZE << c) < bytes)
+    c++;
+
+  return c;
+}
+
+// Get a chunk that has at least the given bytes
+ChunkPool::Chunk ChunkPool::Get(size_t bytes)
+{
+  unsigned c = sizeClass(bytes);
+
+  size_t size = CHUNK_SIZE << c;
+
+
+  // Reuse the free chunk of the class if there is
+
+  if (c < FreeChunks::CLASS_CNT)
+  {
+    FreeChunks& chunks = freeChunks();
+
+    std::lock_guard<std::mutex> lock(chunks.mutex);
+
+    if (!chunks.lists[c].empty())
+    {
+      Chunk chunk = chunks.lists[c].back();
+
+      chunks.lists[c].pop_back();
+
+      chunks.cached -= chunk.size;
+
+      return chunk;
+    }
+  }
+
+
+  // Otherwise, make new one
+
+  char* data = static_cast<char*>(std::aligned_alloc(64, size));
+
+  if (!data)
+    throw std::bad_alloc();
+
+  return Chunk{ data, size };
+}
+
+// Give back the chunk for the next use
+void ChunkPool::Put(Chunk chunk)
+{
+  unsigned c = sizeClass(chunk.size);
+
+  if (c < FreeChunks::CLASS_CNT)
+  {
+    FreeChunks& chunks = freeChunks();
+
+    std::lock_guard<std::mutex> lock(chunks.mutex);
+
+    if (chunks.cached + chunk.size <= CACHE_MAX)
+    {
+      chunks.lists[c].push_back(chunk);
+
+      chunks.cached += chunk.size;
+
+      return;
+    }
+  }
+
+  // The pool is full, release it
+
+  std::free(chunk.data);
+}
+
+
+// The constructor, workers of the pool have their own chunks
+Arena::Arena(int workerCnt) : slots(new Slot[workerCnt + 1]), workerCnt(workerCnt) {}
+
+// The destructor, return all chunks to the pool
+Arena::~Arena()
+{
+  for (int i = 0; i <= workerCnt; i++)
+  {
+    for (auto& chunk : slots[i].chunks)
+      ChunkPool::Put(chunk);
+  }
+}
+
+// Allocate the bytes, aligned to the cache line
+void* Arena::Allocate(size_t bytes)
+{
+  bytes = (bytes + 63) & ~size_t(63);
+
+  // The worker uses its own slot without lock
+
+  if (local_worker_id >= 0 && local_worker_id < workerCnt)
+    return Allocate(slots[local_worker_id], bytes);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  return Allocate(slots[workerCnt], bytes);
+}
+
+// Allocate from the slot
+void* Arena::Allocate(Slot& slot, size_t bytes)
+{
+  // Large allocation has its own chunk, so the rest of the current chunk is not wasted
+
+  if (bytes > ChunkPool::CHUNK_SIZE / 4)
+  {
+    slot.chunks.push_back(ChunkPool::Get(bytes));
+
+    return slot.chunks.back().data;
+  }
+
+
+  // If the current chunk is full, take new one
+
+  if (size_t(slot.end - slot.now) < bytes)
+  {
+    slot.chunks.push_back(ChunkPool::Get(ChunkPool::CHUNK_SIZE));
+
+    slot.now = slot.chunks.back().data;
+
+    slot.end = slot.now + slot.chunks.back().size;
+  }
+
+  void* p = slot.now;
+
+  slot.now += bytes;
+
+  return p;
+}
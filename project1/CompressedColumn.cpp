@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cstring>
+
+#include "CompressedColumn.hpp"
+#include "Parser.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+constexpr uint64_t DICTIONARY_SIZE_MAX = 1 << 16;  // The column of more distinct values is not a dictionary
+
+
+// The bytes of the code that can have the largest code
+static unsigned codeWidth(uint64_t maxCode)
+{
+  if (maxCode <= UINT8_MAX)
+    return 1;
+
+  if (maxCode <= UINT16_MAX)
+    return 2;
+
+  if (maxCode <= UINT32_MAX)
+    return 4;
+
+  return 8;
+}
+
+// Open addressing table of the distinct values of a column, for the dictionary
+class DistinctTable
+{
+public:
+
+  /// The table for at most the capacity values, at most a half of the slots are used
+  explicit DistinctTable(uint64_t capacity) : capacity(capacity)
+  {
+    uint64_t slotCnt = 2;
+
+    for (shift = 63; slotCnt < 2 * capacity; shift--)
+      slotCnt <<= 1;
+
+    keys.resize(slotCnt);
+
+    codes.assign(slotCnt, 0);
+  }
+
+  /// Insert the value, return false if the table already has the capacity values
+  bool Insert(uint64_t value)
+  {
+    uint64_t slot = Find(value);
+
+    if (codes[slot])
+      return true;
+
+    if (count == capacity)
+      return false;
+
+    keys[slot] = value;
+
+    codes[slot] = ++count;
+
+    return true;
+  }
+
+  /// The slot of the value, or the empty slot where it is inserted
+  uint64_t Find(uint64_t value) const
+  {
+    uint64_t slot = (value * 0x9E3779B97F4A7C15ull) >> shift;
+
+    while (codes[slot] && keys[slot] != value)
+      slot = (slot + 1) & (keys.size() - 1);
+
+    return slot;
+  }
+
+  /// The sorted distinct values, then the code of each value is its index in them
+  std::vector<uint64_t> Sort()
+  {
+    std::vector<uint64_t> values;
+
+    for (uint64_t slot = 0; slot < keys.size(); slot++)
+    {
+      if (codes[slot])
+        values.push_back(keys[slot]);
+    }
+
+    std::sort(values.begin(), values.end());
+
+    for (uint32_t code = 0; code < values.size(); code++)
+      codes[Find(values[code])] = code + 1;
+
+    return values;
+  }
+
+  /// The code of the inserted value
+  uint32_t Code(uint64_t value) const { return codes[Find(value)] - 1; }
+
+private:
+
+  uint64_t capacity;
+
+  unsigned shift;
+
+  std::vector<uint64_t> keys;
+
+  /// The code of the value plus one, 0 if the slot is empty
+  std::vector<uint32_t> codes;
+
+  uint64_t count = 0;
+
+};
+
+// Store the codes of the column
+template <typename T, typename F>
+static void encode(const uint64_t* col, uint64_t size, std::vector<uint8_t>& codes, F&& code)
+{
+  codes.resize(size * sizeof(T));
+
+  T* out = reinterpret_cast<T*>(codes.data());
+
+  for (uint64_t i = 0; i < size; i++)
+    out[i] = code(col[i]);
+}
+
+// Choose the encoding of the column, then encode it
+void CompressedColumn::Build(const uint64_t* col, uint64_t size, uint64_t min, uint64_t max)
+{
+  encoding = Encoding::None;
+
+  dictionary.clear();
+
+  codes.clear();
+
+  if (size == 0)
+    return;
+
+
+  // The frame of reference needs the bytes of the range
+
+  base = min;
+
+  maxCode = max - min;
+
+  width = codeWidth(maxCode);
+
+
+  // If the range is wide, the column may still have a few distinct values
+  // The dictionary is used only if its codes are narrower, so stop counting the distinct values as soon as they are too many for that
+
+  if (width > 1)
+  {
+    DistinctTable distinct(width == 2 ? UINT8_MAX + 1 : DICTIONARY_SIZE_MAX);
+
+    uint64_t i = 0;
+
+    while (i < size && distinct.Insert(col[i]))
+      i++;
+
+    if (i == size)
+    {
+      dictionary = distinct.Sort();
+
+      maxCode = dictionary.size() - 1;
+
+      width = codeWidth(maxCode);
+
+      encoding = Encoding::Dictionary;
+
+      auto code = [&distinct](uint64_t value) { return distinct.Code(value); };
+
+      if (width == 1)
+        encode<uint8_t>(col, size, codes, code);
+      else
+        encode<uint16_t>(col, size, codes, code);
+
+      return;
+    }
+  }
+
+
+  // The codes of the frame of reference
+
+  encoding = Encoding::FrameOfReference;
+
+  auto code = [this](uint64_t value) { return value - base; };
+
+  if (width == 1)
+    encode<uint8_t>(col, size, codes, code);
+  else if (width == 2)
+    encode<uint16_t>(col, size, codes, code);
+  else if (width == 4)
+    encode<uint32_t>(col, size, codes, code);
+  else
+    encoding = Encoding::None;
+}
+
+// Translate the filter on the values to the filter on the codes
+FilterInfo CompressedColumn::TranslateFilter(const FilterInfo& filter) const
+{
+  // The codes are less than 2^32, so comparing with the largest 64 bit value passes every code or no code
+
+  FilterInfo none(filter.filterColumn, UINT64_MAX, FilterInfo::Comparison::Equal);
+
+  FilterInfo all(filter.filterColumn, UINT64_MAX, FilterInfo::Comparison::Less);
+
+  uint64_t constant = filter.constant;
+
+  if (encoding == Encoding::FrameOfReference)
+  {
+    switch (filter.comparison)
+    {
+      case FilterInfo::Comparison::Equal:
+
+        return constant < base || constant - base > maxCode ? none : FilterInfo(filter.filterColumn, constant - base, filter.comparison);
+
+      case FilterInfo::Comparison::Greater:
+
+        return constant < base ? all : FilterInfo(filter.filterColumn, constant - base, filter.comparison);
+
+      case FilterInfo::Comparison::Less:
+
+        return constant <= base ? none : FilterInfo(filter.filterColumn, constant - base, filter.comparison);
+    };
+  }
+
+
+  // The position of the constant in the sorted values
+
+  uint64_t lower = std::lower_bound(dictionary.begin(), dictionary.end(), constant) - dictionary.begin();
+
+  switch (filter.comparison)
+  {
+    case FilterInfo::Comparison::Equal:
+
+      return lower < dictionary.size() && dictionary[lower] == constant ? FilterInfo(filter.filterColumn, lower, filter.comparison) : none;
+
+    case FilterInfo::Comparison::Less:
+
+      return FilterInfo(filter.filterColumn, lower, filter.comparison);
+
+    case FilterInfo::Comparison::Greater:
+    {
+      // The values greater than the constant have the codes from its upper bound
+
+      uint64_t upper = lower < dictionary.size() && dictionary[lower] == constant ? lower + 1 : lower;
+
+      return upper == 0 ? all : FilterInfo(filter.filterColumn, upper - 1, filter.comparison);
+    }
+  };
+
+  return all;
+}
+
+// Widen the codes with the scalar loop
+template <typename T>
+static void widenScalar(const uint8_t* codes, uint32_t count, uint64_t* out)
+{
+  auto in = reinterpret_cast<const T*>(codes);
+
+  for (uint32_t i = 0; i < count; i++)
+    out[i] = in[i];
+}
+
+#if defined(__x86_64__)
+// Widen the codes with AVX2, 4 codes at once
+template <typename T>
+__attribute__((target("avx2")))
+static void widenAVX2(const uint8_t* codes, uint32_t count, uint64_t* out)
+{
+  auto in = reinterpret_cast<const T*>(codes);
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256i values;
+
+    if constexpr (sizeof(T) == 1)
+    {
+      int32_t packed;
+
+      std::memcpy(&packed, in + i, sizeof(packed));
+
+      values = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+    }
+    else if constexpr (sizeof(T) == 2)
+      values = _mm256_cvtepu16_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+    else
+      values = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), values);
+  }
+
+  for (; i < count; i++)
+    out[i] = in[i];
+}
+
+// Widen the codes with AVX-512, 8 codes at once
+template <typename T>
+__attribute__((target("avx512f")))
+static void widenAVX512(const uint8_t* codes, uint32_t count, uint64_t* out)
+{
+  auto in = reinterpret_cast<const T*>(codes);
+
+  uint32_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m512i values;
+
+    if constexpr (sizeof(T) == 1)
+      values = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+    else if constexpr (sizeof(T) == 2)
+      values = _mm512_cvtepu16_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+    else
+      values = _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+
+    _mm512_storeu_si512(out + i, values);
+  }
+
+  for (; i < count; i++)
+    out[i] = in[i];
+}
+#endif
+
+using WidenFunction = void (*)(const uint8_t*, uint32_t, uint64_t*);
+
+// Choose the widest kernel that the cpu supports
+template <typename T>
+static WidenFunction chooseKernel()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return widenAVX512<T>;
+
+  if (__builtin_cpu_supports("avx2"))
+    return widenAVX2<T>;
+#endif
+
+  return widenScalar<T>;
+}
+
+// Widen the codes [start, start + count) to 64 bits
+void CompressedColumn::DecodeCodes(uint64_t start, uint32_t count, uint64_t* out) const
+{
+  static const WidenFunction widen8 = chooseKernel<uint8_t>();
+
+  static const WidenFunction widen16 = chooseKernel<uint16_t>();
+
+  static const WidenFunction widen32 = chooseKernel<uint32_t>();
+
+  const uint8_t* in = codes.data() + start * width;
+
+  if (width == 1)
+    widen8(in, count, out);
+  else if (width == 2)
+    widen16(in, count, out);
+  else
+    widen32(in, count, out);
+}
@@ -0,0 +1,157 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "Explain.hpp"
+#include "Operators.hpp"
+#include "Parser.hpp"
+
+
+using namespace std;
+
+
+// The format asked by EXPLAIN_ANALYZE, read once
+Explain::Format Explain::Mode()
+{
+  static const Format format = []()
+                               {
+                                 const char* value = getenv("EXPLAIN_ANALYZE");
+
+                                 if (!value || !*value || strcmp(value, "0") == 0)
+                                   return Format::Off;
+
+                                 return strcmp(value, "json") == 0 ? Format::Json : Format::Text;
+                               }();
+
+  return format;
+}
+
+
+// The actual result size, the streamed operator counts its morsels instead of the materialized result
+static uint64_t actualSize(Operator& op)
+{
+  uint64_t produced = op.profile.producedSize.load();
+
+  return produced ? produced : op.resultSize;
+}
+
+// Milliseconds of the nanoseconds
+static double ms(uint64_t ns)
+{
+  return ns / 1e6;
+}
+
+// One line per operator, the inputs are indented below
+static void dumpText(Operator& op, unsigned depth, ostream& out)
+{
+  auto& p = op.profile;
+
+  uint64_t actual = actualSize(op);
+
+  out << string(depth * 2, ' ') << op.explainName() << "  rows=" << actual;
+
+
+  // How far the estimate is, in either direction, so the misestimated joins stand out
+
+  if (p.expectedSize >= 0)
+  {
+    double expected = max(p.expectedSize, 1.0);
+
+    double ratio = max<double>(actual, 1) / expected;
+
+    out << " est=" << (uint64_t)p.expectedSize << " (" << (ratio >= 1 ? "x" : "/") << (ratio >= 1 ? ratio : 1 / ratio) << ")";
+  }
+
+  out << " time=" << ms(p.wallNs) << "ms";
+
+  if (p.buildWallNs)
+    out << " build=" << ms(p.buildWallNs) << "ms cpu=" << ms(p.buildCpuNs) << "ms";
+
+  if (p.hashTableSize)
+    out << " ht=" << p.hashTableSize;
+
+  if (p.probeWallNs)
+    out << " probe=" << ms(p.probeWallNs) << "ms cpu=" << ms(p.probeCpuNs) << "ms";
+
+  if (p.tasks)
+    out << " tasks=" << p.tasks;
+
+  if (p.bytesMaterialized)
+    out << " materialized=" << p.bytesMaterialized << "B";
+
+  out << "\n";
+
+  for (auto input : op.explainInputs())
+    dumpText(*input, depth + 1, out);
+}
+
+// One object per operator, the inputs are nested
+static void dumpJson(Operator& op, ostream& out)
+{
+  auto& p = op.profile;
+
+  out << "{\"operator\":\"" << op.explainName() << "\""
+      << ",\"rows\":" << actualSize(op);
+
+  if (p.expectedSize >= 0)
+    out << ",\"estimated_rows\":" << p.expectedSize;
+
+  out << ",\"wall_ms\":" << ms(p.wallNs)
+      << ",\"build_wall_ms\":" << ms(p.buildWallNs)
+      << ",\"build_cpu_ms\":" << ms(p.buildCpuNs)
+      << ",\"probe_wall_ms\":" << ms(p.probeWallNs)
+      << ",\"probe_cpu_ms\":" << ms(p.probeCpuNs)
+      << ",\"hash_table_size\":" << p.hashTableSize
+      << ",\"tasks\":" << p.tasks
+      << ",\"bytes_materialized\":" << p.bytesMaterialized
+      << ",\"inputs\":[";
+
+  auto inputs = op.explainInputs();
+
+  for (unsigned i = 0; i < inputs.size(); i++)
+  {
+    if (i > 0)
+      out << ",";
+
+    dumpJson(*inputs[i], out);
+  }
+
+  out << "]}";
+}
+
+// The plan tree of the query with the profile of each operator
+string Explain::Dump(QueryInfo& query, Operator& root, Format format)
+{
+  stringstream out;
+
+  if (format == Format::Json)
+  {
+    out << "{\"query\":\"" << query.dumpText() << "\",\"plan\":";
+
+    dumpJson(root, out);
+
+    out << "}\n";
+  }
+  else
+  {
+    out << "EXPLAIN ANALYZE " << query.dumpText() << "\n";
+
+    dumpText(root, 1, out);
+  }
+
+  return out.str();
+}
+
+// Print the plan tree to stderr
+void Explain::Print(QueryInfo& query, Operator& root)
+{
+  static mutex printMutex;
+
+  string plan = Dump(query, root, Mode());
+
+  lock_guard<mutex> lock(printMutex);
+
+  cerr << plan << flush;
+}
@@ -0,0 +1,1377 @@
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "Explain.hpp"
+#include "Joiner.hpp"
+#include "Parser.hpp"
+#include "Threadpool.hpp"
+
+
+extern ThreadPool threadpool;
+
+
+using namespace std;
+
+
+#ifdef INDEX_JOIN_MODE
+constexpr double INDEX_JOIN_RATIO = 16;  // The relation is probed through its index if the other input is this times smaller
+#endif
+
+#ifdef PLAN_CACHE_MODE
+constexpr double PLAN_CACHE_TOLERANCE = 4;     // The cached plan is reused if the scan sizes of the query are within this factor of its estimates
+
+constexpr size_t PLAN_CACHE_CAPACITY = 4096;   // The cache is cleared when it has this many query templates
+#endif
+
+
+// Loads a relation from disk
+void Joiner::addRelation(const char* fileName)
+{
+  relations.emplace_back(fileName);
+}
+
+
+// Loads the relations from disk, in parallel
+// The loading of a relation faults its pages and builds its zone maps, so they are loaded at once
+void Joiner::addRelations(const vector<string>& fileNames)
+{
+#ifdef SINGLE_THREAD_MODE
+  for (auto& fileName : fileNames)
+    addRelation(fileName.c_str());
+#endif
+#ifdef MULTI_THREAD_MODE
+  vector<future<Relation>> loads;
+
+  for (auto& fileName : fileNames)
+    loads.push_back(threadpool.Request([&fileName]() { return Relation(fileName.c_str()); }));
+
+  for (auto& load : loads)
+    relations.push_back(threadpool.RequestGet(std::move(load)));
+#endif
+}
+
+
+// Loads a relation from disk
+Relation& Joiner::getRelation(unsigned relationId)
+{
+  if (relationId >= relations.size()) 
+  {
+    cerr << "Relation with id: " << relationId << " does not exist" << endl;
+
+    throw;
+  }
+
+  return relations[relationId];
+}
+
+
+// Add scan to query
+unique_ptr<Operator> Joiner::addScan(set<unsigned>& usedRelations, SelectInfo& info, QueryInfo& query, const vector<SharedInput>& sharedInputs)
+{
+  // Scan this SelectInfo is also in the query.filters
+
+  usedRelations.emplace(info.binding);
+
+#ifdef SHARED_SUBPLAN_MODE
+  // The filtered scan may be already done for the batch
+
+  for (auto& input : sharedInputs)
+  {
+    if (input.bindings.size() == 1 && input.bindings[0] == info.binding)
+      return make_unique<SharedScan>(input.result, vector<Relation*>{ &getRelation(info.relId) }, input.bindings);
+  }
+#endif
+
+  vector<FilterInfo> filters;
+  
+  for (auto& f : query.filters) 
+  {
+    // If this relation has filtering operations, save these filtering informations
+
+    if (f.filterColumn.binding == info.binding) 
+    {
+      filters.emplace_back(f);
+    }
+  }
+
+  // If this relation has filtering operations, return the operator as FilterScan
+  // else, just return the operator as Scan
+
+  return filters.size() ? make_unique<FilterScan>(getRelation(info.relId), filters) : make_unique<Scan>(getRelation(info.relId), info.binding);
+}
+
+
+#ifdef INDEX_JOIN_MODE
+// Whether the binding is the whole base relation, without filters and predicates inside it
+static bool isBareRelation(QueryInfo& query, unsigned binding)
+{
+  for (auto& f : query.filters)
+  {
+    if (f.filterColumn.binding == binding)
+      return false;
+  }
+
+  for (auto& pInfo : query.predicates)
+  {
+    if (pInfo.left.binding == binding && pInfo.right.binding == binding)
+      return false;
+  }
+
+  return true;
+}
+#endif
+
+
+enum QueryGraphProvides {  Left, Right, Both, None };
+
+
+// Analyzes inputs of join
+static QueryGraphProvides analyzeInputOfJoin(set<unsigned>& usedRelations, SelectInfo& leftInfo, SelectInfo& rightInfo)
+{
+  // Whether this relation is scaned
+
+  bool usedLeft = usedRelations.count(leftInfo.binding);
+
+  bool usedRight = usedRelations.count(rightInfo.binding);
+
+
+  if (usedLeft ^ usedRight)
+    return usedLeft ? QueryGraphProvides::Left : QueryGraphProvides::Right;
+
+  if (usedLeft && usedRight)
+    return QueryGraphProvides::Both;
+
+  return QueryGraphProvides::None;
+}
+
+
+// Join enumeration with the dynamic programming over the connected subgraphs of the query graph (DPccp)
+// The bindings are the vertices and the predicates between two bindings are the edges, a set of bindings is a bit mask
+// Each pair of a connected set and its connected complement is visited only once, and there is no cross product
+// Both left-deep and bushy trees are considered, and the cheapest plan of each set is kept
+class JoinEnumerator
+{
+public:
+
+  /// The cheapest plan of a set of bindings
+  struct Plan
+  {
+    /// The expected result size
+    double cardinality = 0;
+
+    /// The sum of the expected result sizes of the joins in the plan
+    double cost = 0;
+
+    /// The sets of the inputs, zero for a base relation
+    uint32_t left = 0;
+
+    uint32_t right = 0;
+
+    /// Whether the plan of the set is made
+    bool found = false;
+  };
+
+  /// An edge of the query graph
+  struct Edge
+  {
+    uint32_t left;
+
+    uint32_t right;
+
+    double selectivity;
+  };
+
+  /// The plans, indexed by the set of bindings
+  vector<Plan> plans;
+
+  /// Use the result that is already done as the plan of the set, it costs nothing
+  void AddDone(uint32_t s, double cardinality)
+  {
+    plans[s].cardinality = cardinality;
+
+    plans[s].found = true;
+  }
+
+  /// The constructor, the base relations are the plans of the single bindings
+  JoinEnumerator(vector<double>& cardinalities, vector<Edge>& edges) : plans(1u << cardinalities.size()), edges(edges), neighborSets(cardinalities.size())
+  {
+    for (unsigned v = 0; v < cardinalities.size(); v++)
+    {
+      plans[1u << v].cardinality = cardinalities[v];
+
+      plans[1u << v].found = true;
+    }
+
+    for (auto& e : edges)
+    {
+      neighborSets[__builtin_ctz(e.left)] |= e.right;
+
+      neighborSets[__builtin_ctz(e.right)] |= e.left;
+    }
+  }
+
+  /// Enumerate the pairs of the connected sets, from the sets that start with the last binding
+  void Enumerate()
+  {
+    for (int v = neighborSets.size() - 1; v >= 0; v--)
+    {
+      uint32_t s = 1u << v;
+
+      emitCsg(s);
+
+      enumerateCsg(s, (s << 1) - 1);
+    }
+  }
+
+private:
+
+  /// The neighbors of the set
+  uint32_t neighbors(uint32_t s)
+  {
+    uint32_t n = 0;
+
+    for (uint32_t rest = s; rest; rest &= rest - 1)
+      n |= neighborSets[__builtin_ctz(rest)];
+
+    return n & ~s;
+  }
+
+  /// Extend the connected set with the neighbors that are not excluded
+  /// The subsets of the neighbors are visited in increasing order, so the smaller sets are always done first
+  void enumerateCsg(uint32_t s, uint32_t excluded)
+  {
+    uint32_t n = neighbors(s) & ~excluded;
+
+    for (uint32_t sub = n & -n; sub; sub = (sub - n) & n)
+      emitCsg(s | sub);
+
+    for (uint32_t sub = n & -n; sub; sub = (sub - n) & n)
+      enumerateCsg(s | sub, excluded | n);
+  }
+
+  /// Find the connected complements of the connected set
+  /// The bindings before the smallest one of the set are excluded, the pair is visited from them
+  void emitCsg(uint32_t s1)
+  {
+    uint32_t excluded = s1 | (((s1 & -s1) << 1) - 1);
+
+    uint32_t n = neighbors(s1) & ~excluded;
+
+    for (uint32_t rest = n; rest; rest &= ~(1u << (31 - __builtin_clz(rest))))
+    {
+      uint32_t s2 = 1u << (31 - __builtin_clz(rest));
+
+      emitCsgCmp(s1, s2);
+
+      enumerateCmp(s1, s2, excluded | (n & ((s2 << 1) - 1)));
+    }
+  }
+
+  /// Extend the complement with its neighbors that are not excluded
+  void enumerateCmp(uint32_t s1, uint32_t s2, uint32_t excluded)
+  {
+    uint32_t n = neighbors(s2) & ~excluded;
+
+    for (uint32_t sub = n & -n; sub; sub = (sub - n) & n)
+      emitCsgCmp(s1, s2 | sub);
+
+    for (uint32_t sub = n & -n; sub; sub = (sub - n) & n)
+      enumerateCmp(s1, s2 | sub, excluded | n);
+  }
+
+  /// Join the plans of the pair, keep it if it is the cheapest plan of the union
+  void emitCsgCmp(uint32_t s1, uint32_t s2)
+  {
+    Plan& left = plans[s1];
+
+    Plan& right = plans[s2];
+
+    Plan& plan = plans[s1 | s2];
+
+    assert(left.found && right.found);
+
+
+    // The result size does not depend on the order, so it is computed only once
+
+    if (!plan.found)
+    {
+      plan.cardinality = left.cardinality * right.cardinality;
+
+      for (auto& e : edges)
+      {
+        if (((e.left & s1) && (e.right & s2)) || ((e.left & s2) && (e.right & s1)))
+          plan.cardinality *= e.selectivity;
+      }
+    }
+
+    double cost = plan.cardinality + left.cost + right.cost;
+
+    if (!plan.found || cost < plan.cost)
+    {
+      plan.cost = cost;
+
+      plan.left = s1;
+
+      plan.right = s2;
+
+      plan.found = true;
+    }
+  }
+
+
+  vector<Edge>& edges;
+
+  /// The neighbors of each binding
+  vector<uint32_t> neighborSets;
+
+};
+
+
+/// The expected size of each binding after its filters
+vector<double> Joiner::estimateScanSizes(QueryInfo& query)
+{
+  vector<double> sizes(query.relationIds.size());
+
+  for (unsigned binding = 0; binding < sizes.size(); binding++)
+  {
+    SelectInfo info(query.relationIds[binding], binding, 0);
+
+    sizes[binding] = getRelation(info.relId).size * GetSelectivity(info, query.filters);
+  }
+
+  return sizes;
+}
+
+
+/// Find the cheapest plan of the query with the statistics
+shared_ptr<const QueryPlan> Joiner::planQuery(QueryInfo& query, const vector<SharedInput>& sharedInputs)
+{
+  unsigned bindingCnt = query.relationIds.size();
+
+  assert(bindingCnt < 32);
+
+  auto queryPlan = make_shared<QueryPlan>();
+
+
+  // Get the expected size of each relation after its filters
+  // The predicates inside one binding work like the filters too
+
+  queryPlan->scanSizes = estimateScanSizes(query);
+
+  vector<double> cardinalities = queryPlan->scanSizes;
+
+#ifdef SHARED_SUBPLAN_MODE
+  // The size of the filtered scan that is already done is known
+
+  for (auto& input : sharedInputs)
+  {
+    if (input.bindings.size() == 1)
+      cardinalities[input.bindings[0]] = input.result->size;
+  }
+#endif
+
+  // The sizes after the filters are kept for the explain, the predicates inside a binding change the cardinalities
+
+  vector<double> filteredSizes = cardinalities;
+
+  vector<double> selectivities(query.predicates.size());
+
+  vector<JoinEnumerator::Edge> edges;
+
+  for (unsigned i = 0; i < query.predicates.size(); i++)
+  {
+    auto& pInfo = query.predicates[i];
+
+    selectivities[i] = GetSelectivity(pInfo);
+
+    if (pInfo.left.binding == pInfo.right.binding)
+      cardinalities[pInfo.left.binding] *= selectivities[i];
+    else
+      edges.push_back({ 1u << pInfo.left.binding, 1u << pInfo.right.binding, selectivities[i] });
+  }
+
+
+  // Find the cheapest plan of all bindings
+  // The query graph is connected, we never have cross products
+
+  JoinEnumerator enumerator(cardinalities, edges);
+
+#ifdef SHARED_SUBPLAN_MODE
+  // The join that is already done is a free plan, the others may be built on it
+
+  for (auto& input : sharedInputs)
+  {
+    if (input.bindings.size() == 2)
+      enumerator.AddDone((1u << input.bindings[0]) | (1u << input.bindings[1]), input.result->size);
+  }
+#endif
+
+  enumerator.Enumerate();
+
+  assert(enumerator.plans.back().found);
+
+
+  // Make the nodes of the join tree from the top, the inputs are added before their parent
+
+  auto& nodes = queryPlan->nodes;
+
+  auto addNode = [&](PlanNode node)
+  {
+    nodes.push_back(node);
+
+    return int(nodes.size() - 1);
+  };
+
+  // Compare the other predicate on the result, the expected size is reduced by its selectivity
+
+  auto addSelfJoin = [&](int input, unsigned predicate)
+  {
+    return addNode(PlanNode{ PlanNode::Kind::SelfJoin, 0, predicate, input, -1, nodes[input].expectedSize * selectivities[predicate] });
+  };
+
+  function<int(uint32_t)> makeTree = [&](uint32_t bindings)
+  {
+    auto& plan = enumerator.plans[bindings];
+
+    int root;
+
+#ifdef SHARED_SUBPLAN_MODE
+    // The join that is already done, with the predicates inside its bindings
+
+    for (unsigned s = 0; s < sharedInputs.size(); s++)
+    {
+      auto& input = sharedInputs[s];
+
+      if (input.bindings.size() != 2 || bindings != ((1u << input.bindings[0]) | (1u << input.bindings[1])))
+        continue;
+
+      root = addNode(PlanNode{ PlanNode::Kind::SharedScan, s, 0, -1, -1, double(input.result->size) });
+
+      for (unsigned i = 0; i < query.predicates.size(); i++)
+      {
+        auto& pInfo = query.predicates[i];
+
+        if (pInfo.left.binding == pInfo.right.binding && ((1u << pInfo.left.binding) & bindings))
+          root = addSelfJoin(root, i);
+      }
+
+      return root;
+    }
+#endif
+
+
+    // Base relation, with the predicates inside it
+
+    if (!plan.left)
+    {
+      unsigned binding = __builtin_ctz(bindings);
+
+      root = addNode(PlanNode{ PlanNode::Kind::Scan, binding, 0, -1, -1, filteredSizes[binding] });
+
+      for (unsigned i = 0; i < query.predicates.size(); i++)
+      {
+        auto& pInfo = query.predicates[i];
+
+        if (pInfo.left.binding == binding && pInfo.right.binding == binding)
+          root = addSelfJoin(root, i);
+      }
+
+      return root;
+    }
+
+
+    // Join the inputs with the most selective predicate between them
+    // The other predicates between them are compared on the result of the join
+
+    vector<unsigned> between;
+
+    for (unsigned i = 0; i < query.predicates.size(); i++)
+    {
+      auto& pInfo = query.predicates[i];
+
+      uint32_t l = 1u << pInfo.left.binding, r = 1u << pInfo.right.binding;
+
+      if (((l & plan.left) && (r & plan.right)) || ((l & plan.right) && (r & plan.left)))
+        between.push_back(i);
+    }
+
+#ifdef INDEX_JOIN_MODE
+    // If one input is a whole base relation and the other input is much smaller,
+    // probe the index of the relation with the other input instead of scanning the relation
+    // The join uses the most selective predicate on the indexed columns
+
+    for (uint32_t inner : { plan.right, plan.left })
+    {
+      unsigned binding = __builtin_ctz(inner);
+
+      Relation& relation = getRelation(query.relationIds[binding]);
+
+      if (__builtin_popcount(inner) != 1 || !isBareRelation(query, binding) || relation.indexes.empty() ||
+          enumerator.plans[bindings ^ inner].cardinality * INDEX_JOIN_RATIO > relation.size)
+        continue;
+
+      int indexed = -1;
+
+      for (unsigned i : between)
+      {
+        auto& pInfo = query.predicates[i];
+
+        auto& key = pInfo.left.binding == binding ? pInfo.left : pInfo.right;
+
+        if (relation.indexes[key.colId].Built() && (indexed < 0 || selectivities[i] < selectivities[indexed]))
+          indexed = i;
+      }
+
+      if (indexed < 0)
+        continue;
+
+      int outer = makeTree(bindings ^ inner);
+
+      root = addNode(PlanNode{ PlanNode::Kind::IndexJoin, binding, unsigned(indexed), outer, -1,
+                               enumerator.plans[bindings ^ inner].cardinality * relation.size * selectivities[indexed] });
+
+      for (unsigned i : between)
+      {
+        if (i != (unsigned)indexed)
+          root = addSelfJoin(root, i);
+      }
+
+      return root;
+    }
+#endif
+
+    int left = makeTree(plan.left);
+
+    int right = makeTree(plan.right);
+
+    unsigned first = *min_element(between.begin(), between.end(), [&](unsigned a, unsigned b) { return selectivities[a] < selectivities[b]; });
+
+    auto& pInfo = query.predicates[first];
+
+
+    // The left of the predicate is in the left input of the join
+
+    if ((1u << pInfo.left.binding) & plan.right)
+      swap(left, right);
+
+    root = addNode(PlanNode{ PlanNode::Kind::Join, 0, first, left, right,
+                             enumerator.plans[plan.left].cardinality * enumerator.plans[plan.right].cardinality * selectivities[first] });
+
+    for (unsigned i : between)
+    {
+      if (i != first)
+        root = addSelfJoin(root, i);
+    }
+
+    return root;
+  };
+
+  makeTree((1u << bindingCnt) - 1);
+
+  return queryPlan;
+}
+
+
+/// Make the operators of the node of the plan, with the constants of the query
+unique_ptr<Operator> Joiner::makeOperators(QueryInfo& query, const QueryPlan& plan, int node, set<unsigned>& usedRelations, const vector<SharedInput>& sharedInputs)
+{
+  auto& planNode = plan.nodes[node];
+
+  unique_ptr<Operator> root;
+
+  switch (planNode.kind)
+  {
+    case PlanNode::Kind::Scan:
+    {
+      // The filters of the binding are taken from the query, so the scan has the constants of this query
+
+      SelectInfo info(query.relationIds[planNode.binding], planNode.binding, 0);
+
+      root = addScan(usedRelations, info, query, sharedInputs);
+
+      break;
+    }
+
+#ifdef SHARED_SUBPLAN_MODE
+    case PlanNode::Kind::SharedScan:
+    {
+      auto& input = sharedInputs[planNode.binding];
+
+      vector<Relation*> relations;
+
+      for (auto binding : input.bindings)
+        relations.push_back(&getRelation(query.relationIds[binding]));
+
+      root = make_unique<SharedScan>(input.result, relations, input.bindings);
+
+      break;
+    }
+#endif
+
+    case PlanNode::Kind::Join:
+
+      root = make_unique<Join>(makeOperators(query, plan, planNode.left, usedRelations, sharedInputs), 
+                               makeOperators(query, plan, planNode.right, usedRelations, sharedInputs), query.predicates[planNode.predicate]);
+
+      break;
+
+#ifdef INDEX_JOIN_MODE
+    case PlanNode::Kind::IndexJoin:
+    {
+      auto& pInfo = query.predicates[planNode.predicate];
+
+      bool innerLeft = pInfo.left.binding == planNode.binding;
+
+      usedRelations.emplace(planNode.binding);
+
+      root = make_unique<IndexJoin>(makeOperators(query, plan, planNode.left, usedRelations, sharedInputs), getRelation(query.relationIds[planNode.binding]), 
+                                    innerLeft ? pInfo.right : pInfo.left, innerLeft ? pInfo.left : pInfo.right);
+
+      break;
+    }
+#endif
+
+    case PlanNode::Kind::SelfJoin:
+
+      root = make_unique<SelfJoin>(makeOperators(query, plan, planNode.left, usedRelations, sharedInputs), query.predicates[planNode.predicate]);
+
+      break;
+
+    default:
+
+      assert(false && "the plan has a node of the disabled mode");
+  }
+
+  root->profile.expectedSize = planNode.expectedSize;
+
+  return root;
+}
+
+
+#ifdef PLAN_CACHE_MODE
+// The key of the query template, the relations, the predicates, and the columns and the comparisons of the filters
+// The constants of the filters and the selections do not change the plan, so they are not in the key
+static string templateKey(QueryInfo& query)
+{
+  string key;
+
+  key.reserve(sizeof(unsigned) * (3 + query.relationIds.size() + query.predicates.size() * 4 + query.filters.size() * 3));
+
+  auto add = [&key](unsigned value) { key.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+  add(query.relationIds.size());
+
+  for (auto relationId : query.relationIds)
+    add(relationId);
+
+  add(query.predicates.size());
+
+  for (auto& pInfo : query.predicates)
+  {
+    add(pInfo.left.binding);
+
+    add(pInfo.left.colId);
+
+    add(pInfo.right.binding);
+
+    add(pInfo.right.colId);
+  }
+
+  add(query.filters.size());
+
+  for (auto& f : query.filters)
+  {
+    add(f.filterColumn.binding);
+
+    add(f.filterColumn.colId);
+
+    add(f.comparison);
+  }
+
+  return key;
+}
+
+
+// Whether the plan fits the scan sizes of the query
+// The constants of the query may make a binding much larger or smaller than when the plan was made, then the join order may be wrong
+static bool fitsPlan(const QueryPlan& plan, const vector<double>& scanSizes)
+{
+  for (unsigned binding = 0; binding < scanSizes.size(); binding++)
+  {
+    double planned = max(plan.scanSizes[binding], 1.0), size = max(scanSizes[binding], 1.0);
+
+    if (planned > size * PLAN_CACHE_TOLERANCE || size > planned * PLAN_CACHE_TOLERANCE)
+      return false;
+  }
+
+  return true;
+}
+
+
+// The plan of the template of the query
+// The workload repeats the same query shapes with the other constants, so the plan of a shape is made once,
+// then only the scan sizes of the query are estimated to check that the plan still fits
+// The expected sizes of the reused plan are those of the query that made it
+shared_ptr<const QueryPlan> Joiner::cachedPlan(QueryInfo& query)
+{
+  string key = templateKey(query);
+
+  shared_ptr<const QueryPlan> plan;
+
+  {
+#ifdef MULTI_THREAD_MODE
+    lock_guard<mutex> lock(planCacheMutex);
+#endif
+
+    auto found = planCache.find(key);
+
+    if (found != planCache.end())
+      plan = found->second;
+  }
+
+  if (plan && fitsPlan(*plan, estimateScanSizes(query)))
+    return plan;
+
+
+  // Plan the query, then keep its plan for the template
+
+  plan = planQuery(query, {});
+
+#ifdef MULTI_THREAD_MODE
+  lock_guard<mutex> lock(planCacheMutex);
+#endif
+
+  if (planCache.size() >= PLAN_CACHE_CAPACITY)
+    planCache.clear();
+
+  planCache[key] = plan;
+
+  return plan;
+}
+#endif
+
+
+/// Optimize joins, make the join tree that has the smallest cost
+unique_ptr<Operator> Joiner::Optimize(QueryInfo& query, const vector<SharedInput>& sharedInputs)
+{
+  // The plan with the shared inputs depends on the batch, so it is not cached
+
+#ifdef PLAN_CACHE_MODE
+  shared_ptr<const QueryPlan> plan = sharedInputs.empty() ? cachedPlan(query) : planQuery(query, sharedInputs);
+#else
+  shared_ptr<const QueryPlan> plan = planQuery(query, sharedInputs);
+#endif
+
+  set<unsigned> usedRelations;
+
+  return makeOperators(query, *plan, plan->nodes.size() - 1, usedRelations, sharedInputs);
+}
+
+
+/// Get selectivity
+double Joiner::GetSelectivity(SelectInfo& info, std::vector<FilterInfo>& filters)
+{
+  double selectivity = 1;
+
+  for (auto& f : filters) 
+  {
+    // If this relation has filtering operations, save these filtering informations
+
+    if (f.filterColumn.binding == info.binding) 
+    {
+      selectivity *= GetSelectivity(f);
+    }
+  }
+
+  return selectivity;
+}
+
+
+/// Get selectivity
+double Joiner::GetSelectivity(FilterInfo& info)
+{
+  Relation& r = getRelation(info.filterColumn.relId);
+
+  int colId = info.filterColumn.colId;
+
+
+  // Without the histograms, guess it
+
+  if (r.histograms.empty())
+    return info.comparison == FilterInfo::Comparison::Equal ? 0.1 : 0.5;
+
+
+  // The equi-depth histogram is accurate on the skewed column, use it if there is
+  // But the most common values have their exact counts in the histogram
+
+  if (!r.equiDepthHistograms.empty() && !(info.comparison == FilterInfo::Comparison::Equal && r.histograms[colId].IsCommon(info.constant)))
+  {
+    auto& equiDepthHistogram = r.equiDepthHistograms[colId];
+
+    switch (info.comparison)
+    {
+    case FilterInfo::Comparison::Less:
+
+      return equiDepthHistogram.GetLowerSelectivity(info.constant);
+
+    case FilterInfo::Comparison::Greater:
+
+      return equiDepthHistogram.GetUpperSelectivity(info.constant);
+
+    case FilterInfo::Comparison::Equal:
+
+      return equiDepthHistogram.GetEquiSelectivity(info.constant);
+    }
+  }
+
+
+  switch (info.comparison)
+  {
+  case FilterInfo::Comparison::Less:
+    
+    return r.histograms[colId].GetLowerSelectivity(info.constant);
+
+  case FilterInfo::Comparison::Greater:
+
+    return r.histograms[colId].GetUpperSelectivity(info.constant);
+
+  case FilterInfo::Comparison::Equal:
+
+    return r.histograms[colId].GetEquiSelectivity(info.constant);
+  }
+
+  return 1;
+}
+
+
+/// Get selectivity
+double Joiner::GetSelectivity(PredicateInfo& predicate)
+{
+  Relation& left_relation = getRelation(predicate.left.relId);
+
+  Relation& right_relation = getRelation(predicate.right.relId);
+
+
+  // Without the histograms, assume the join of a key and a foreign key
+
+  if (left_relation.histograms.empty() || right_relation.histograms.empty())
+    return 1 / (double)std::max<uint64_t>({ left_relation.size, right_relation.size, 1 });
+
+
+  // The buckets of the equi-depth histograms also find the frequent values that are not the most common values
+
+  if (!left_relation.equiDepthHistograms.empty() && !right_relation.equiDepthHistograms.empty())
+    return left_relation.equiDepthHistograms[predicate.left.colId].GetJoinSelectivity(right_relation.equiDepthHistograms[predicate.right.colId]);
+
+
+  // Compare the histograms of the join columns
+
+  return left_relation.histograms[predicate.left.colId].GetJoinSelectivity(right_relation.histograms[predicate.right.colId]);
+}
+
+
+// Make the left-deep join tree in the order of the predicates
+unique_ptr<Operator> Joiner::makeLeftDeepTree(QueryInfo& query, const vector<SharedInput>& sharedInputs)
+{
+  set<unsigned> usedRelations;
+
+
+  // Make Operators about first join
+  // With addScan(), find filtering operations to the target relation
+
+  auto& firstJoin = query.predicates[0];
+
+  auto left = addScan(usedRelations, firstJoin.left, query, sharedInputs);
+  
+  auto right = addScan(usedRelations, firstJoin.right, query, sharedInputs);
+
+
+  // Make first join operator as a root of join tree
+
+  unique_ptr<Operator> root = make_unique<Join>(move(left), move(right), firstJoin);
+
+
+  // Add another operators into join tree
+
+  for (unsigned i = 1; i < query.predicates.size(); i++) 
+  {
+    // Make Operator about join
+
+    auto& pInfo = query.predicates[i];
+
+    auto& leftInfo = pInfo.left; auto& rightInfo = pInfo.right;
+
+    unique_ptr<Operator> left, right;
+
+
+    // Push new join operator to the join tree
+    
+    switch(analyzeInputOfJoin(usedRelations, leftInfo, rightInfo)) 
+    {
+      case QueryGraphProvides::Left:
+
+        // If left realtion is already in join tree,
+        // Change left of this join operator as root, new join operator will be new root
+
+        left = move(root);
+
+        right = addScan(usedRelations, rightInfo, query, sharedInputs);
+        
+        root = make_unique<Join>(move(left), move(right), pInfo);
+        
+        break;
+
+      case QueryGraphProvides::Right:
+
+        // If right realtion is already in join tree,
+        // Change right of this join operator as root, new join operator will be new root
+        
+        left = addScan(usedRelations, leftInfo, query, sharedInputs);
+        
+        right = move(root);
+        
+        root = make_unique<Join>(move(left), move(right), pInfo);
+
+        break;
+      
+      case QueryGraphProvides::Both:
+        
+        // All relations of this join are already used somewhere else in the query.
+        // Thus, we have either a cycle in our join graph or more than one join predicate per join.
+        
+        root = make_unique<SelfJoin>(move(root), pInfo);
+        
+        break;
+      
+      case QueryGraphProvides::None:
+        
+        // Process this predicate later when we can connect it to the other joins
+        // We never have cross products
+        
+        query.predicates.push_back(pInfo);
+        
+        break;
+    };
+  }
+
+  return root;
+}
+
+
+// Executes a join query
+string Joiner::join(QueryInfo& query, const vector<SharedInput>& sharedInputs)
+{
+  //cerr << query.dumpText() << endl;
+
+#ifdef QUERY_OPTIMIZE_MODE
+  // Find the cheapest join tree with the statistics, it can be bushy
+
+  unique_ptr<Operator> root = Optimize(query, sharedInputs);
+#else
+  // Join in the order of the predicates
+
+  unique_ptr<Operator> root = makeLeftDeepTree(query, sharedInputs);
+#endif
+
+
+  // Join and get the sum
+  // The intermediate results are allocated from the arena of this query, and released together when the query is done
+
+#ifdef MULTI_THREAD_MODE
+  Arena arena(threadpool.Size());
+#else
+  Arena arena(0);
+#endif
+
+  // Fuse the checksum into the root, so the root sums the required columns in its probe loop
+  // and its result is never materialized
+  // In pipeline mode, the streamable root is already summed morsel by morsel without materialization
+
+#ifdef PIPELINE_MODE
+  if (!root->streamable())
+    root->fuseChecksum();
+#else
+  root->fuseChecksum();
+#endif
+
+  Checksum checkSum(move(root), query.selections);
+
+  checkSum.setArena(&arena);
+  
+  checkSum.run();
+
+  if (Explain::On())
+    Explain::Print(query, checkSum);
+
+
+  // Print results
+
+  stringstream out;
+
+  auto& results = checkSum.checkSums;
+  
+  for (unsigned i = 0; i < results.size(); i++) 
+  {
+    out << (checkSum.resultSize == 0 ? "NULL" : to_string(results[i]));
+
+    if (i < results.size() - 1)
+      out << " ";
+  }
+
+  out << "\n";
+  
+  return out.str();
+}
+
+#ifdef SHARED_SUBPLAN_MODE
+// The key of the filtered scan of the binding, the same relation with the same filters has the same key in any query
+static string scanKey(QueryInfo& query, unsigned binding)
+{
+  vector<string> filters;
+
+  for (auto& f : query.filters)
+  {
+    if (f.filterColumn.binding == binding)
+      filters.push_back(to_string(f.filterColumn.colId) + char(f.comparison) + to_string(f.constant));
+  }
+
+  sort(filters.begin(), filters.end());
+
+  string key = to_string(query.relationIds[binding]);
+
+  for (auto& f : filters)
+    key += "&" + f;
+
+  return key;
+}
+
+
+// The key of the join of the two bindings with all predicates between them
+// The bindings are ordered by their scan keys, so the same join has the same key and the same order in any query
+static string joinKey(QueryInfo& query, vector<unsigned>& bindings)
+{
+  string left = scanKey(query, bindings[0]), right = scanKey(query, bindings[1]);
+
+  if (right < left)
+  {
+    swap(left, right);
+
+    swap(bindings[0], bindings[1]);
+  }
+
+  vector<string> predicates;
+
+  for (auto& pInfo : query.predicates)
+  {
+    if (pInfo.left.binding == bindings[0] && pInfo.right.binding == bindings[1])
+      predicates.push_back(to_string(pInfo.left.colId) + "=" + to_string(pInfo.right.colId));
+    else if (pInfo.left.binding == bindings[1] && pInfo.right.binding == bindings[0])
+      predicates.push_back(to_string(pInfo.right.colId) + "=" + to_string(pInfo.left.colId));
+  }
+
+  sort(predicates.begin(), predicates.end());
+
+  string key = left + "|" + right;
+
+  for (auto& p : predicates)
+    key += "|" + p;
+
+  return key;
+}
+
+
+// Whether the join of the two bindings is expected to be smaller than its inputs
+// The larger result costs more to keep than to join again in each query
+bool Joiner::isSmallJoin(QueryInfo& query, const vector<unsigned>& bindings)
+{
+  double inputs[2];
+
+  for (unsigned i = 0; i < 2; i++)
+  {
+    SelectInfo info(query.relationIds[bindings[i]], bindings[i], 0);
+
+    inputs[i] = getRelation(info.relId).size * GetSelectivity(info, query.filters);
+  }
+
+  double result = inputs[0] * inputs[1];
+
+  for (auto& pInfo : query.predicates)
+  {
+    if ((pInfo.left.binding == bindings[0] && pInfo.right.binding == bindings[1]) || (pInfo.left.binding == bindings[1] && pInfo.right.binding == bindings[0]))
+      result *= GetSelectivity(pInfo);
+  }
+
+  return result <= inputs[0] + inputs[1];
+}
+
+
+// Run the subplan of the bindings of the query, its result is shared by the queries that have the same subplan
+shared_ptr<const SharedResult> Joiner::runSharedSubplan(QueryInfo& query, const vector<unsigned>& bindings)
+{
+  // Make the query of the subplan, the bindings are renamed to their order
+
+  QueryInfo subquery;
+
+  auto position = [&](unsigned binding) { return unsigned(find(bindings.begin(), bindings.end(), binding) - bindings.begin()); };
+
+  for (auto binding : bindings)
+    subquery.relationIds.push_back(query.relationIds[binding]);
+
+  for (auto& f : query.filters)
+  {
+    if (position(f.filterColumn.binding) < bindings.size())
+      subquery.filters.emplace_back(SelectInfo(f.filterColumn.relId, position(f.filterColumn.binding), f.filterColumn.colId), f.constant, f.comparison);
+  }
+
+  for (auto& pInfo : query.predicates)
+  {
+    unsigned left = position(pInfo.left.binding), right = position(pInfo.right.binding);
+
+    if (left == right || left == bindings.size() || right == bindings.size())
+      continue;
+
+    // The left of the predicate is in the left input of the join
+
+    SelectInfo leftInfo(pInfo.left.relId, left, pInfo.left.colId), rightInfo(pInfo.right.relId, right, pInfo.right.colId);
+
+    if (left < right)
+      subquery.predicates.emplace_back(leftInfo, rightInfo);
+    else
+      subquery.predicates.emplace_back(rightInfo, leftInfo);
+  }
+
+
+  // Make the plan, the scan of the relation or the join of the two relations
+  // The most selective predicate joins, the others are compared on the joined tuples
+
+  set<unsigned> usedRelations;
+
+  SelectInfo first(subquery.relationIds[0], 0, 0);
+
+  unique_ptr<Operator> root = addScan(usedRelations, first, subquery, {});
+
+  if (bindings.size() == 2)
+  {
+    vector<double> selectivities;
+
+    for (auto& pInfo : subquery.predicates)
+      selectivities.push_back(GetSelectivity(pInfo));
+
+    swap(subquery.predicates[0], subquery.predicates[min_element(selectivities.begin(), selectivities.end()) - selectivities.begin()]);
+
+    SelectInfo second(subquery.relationIds[1], 1, 0);
+
+    root = make_unique<Join>(move(root), addScan(usedRelations, second, subquery, {}), subquery.predicates[0]);
+
+    for (unsigned i = 1; i < subquery.predicates.size(); i++)
+      root = make_unique<SelfJoin>(move(root), subquery.predicates[i]);
+  }
+
+
+  // Run it with a column of each relation, then keep the row ids of the relations
+  // The row ids are in the arena of the shared result, so they live after the plan is released
+
+  auto shared = make_shared<SharedResult>(threadpool.Size());
+
+  vector<SelectInfo> columns;
+
+  for (unsigned binding = 0; binding < bindings.size(); binding++)
+    columns.emplace_back(subquery.relationIds[binding], binding, 0);
+
+  for (auto& info : columns)
+    root->require(info);
+
+  root->setArena(&shared->arena);
+
+  root->run();
+
+  shared->size = root->resultSize;
+
+  for (auto& info : columns)
+    shared->rowIds.push_back(root->getColumn(info).rowIds);
+
+  return shared;
+}
+
+
+// Joins the queries of a batch
+// The filtered scans and the joins of two bindings that appear in several queries are run once before the queries,
+// then the queries refer their results, and each result is released when its last query is done
+vector<string> Joiner::joinBatch(vector<QueryInfo>& queries)
+{
+  /// A subplan of a query that may be shared
+  struct Subplan
+  {
+    string key;
+
+    vector<unsigned> bindings;
+  };
+
+  vector<vector<Subplan>> chosen(queries.size());
+
+  vector<vector<bool>> covered(queries.size());
+
+  for (unsigned q = 0; q < queries.size(); q++)
+    covered[q].assign(queries[q].relationIds.size(), false);
+
+
+  // Keep the subplans that are chosen by more than one query
+
+  auto keepShared = [&](vector<vector<Subplan>>& candidates)
+  {
+    unordered_map<string, unsigned> counts;
+
+    for (auto& subplans : candidates)
+    {
+      for (auto& subplan : subplans)
+        counts[subplan.key]++;
+    }
+
+    for (unsigned q = 0; q < queries.size(); q++)
+    {
+      for (auto& subplan : candidates[q])
+      {
+        if (counts[subplan.key] < 2)
+          continue;
+
+        for (auto binding : subplan.bindings)
+          covered[q][binding] = true;
+
+        chosen[q].push_back(subplan);
+      }
+    }
+  };
+
+#ifdef QUERY_OPTIMIZE_MODE
+  // The joins of two bindings first
+  // A query takes the most common joins that do not overlap, if they are not larger than their inputs
+
+  vector<vector<Subplan>> joins(queries.size());
+
+  unordered_map<string, unsigned> joinCounts;
+
+  for (unsigned q = 0; q < queries.size(); q++)
+  {
+    set<pair<unsigned, unsigned>> seen;
+
+    for (auto& pInfo : queries[q].predicates)
+    {
+      auto edge = minmax(pInfo.left.binding, pInfo.right.binding);
+
+      if (edge.first == edge.second || !seen.insert(edge).second)
+        continue;
+
+      Subplan join{ "", { edge.first, edge.second } };
+
+      join.key = joinKey(queries[q], join.bindings);
+
+      joinCounts[join.key]++;
+
+      joins[q].push_back(join);
+    }
+  }
+
+  for (unsigned q = 0; q < queries.size(); q++)
+  {
+    stable_sort(joins[q].begin(), joins[q].end(), [&](const Subplan& a, const Subplan& b) { return joinCounts[a.key] > joinCounts[b.key]; });
+
+    vector<bool> taken(queries[q].relationIds.size(), false);
+
+    vector<Subplan> candidates;
+
+    for (auto& join : joins[q])
+    {
+      if (joinCounts[join.key] < 2 || taken[join.bindings[0]] || taken[join.bindings[1]] || !isSmallJoin(queries[q], join.bindings))
+        continue;
+
+      taken[join.bindings[0]] = taken[join.bindings[1]] = true;
+
+      candidates.push_back(join);
+    }
+
+    joins[q].swap(candidates);
+  }
+
+  keepShared(joins);
+#endif
+
+
+  // Then the filtered scans of the other bindings
+
+  vector<vector<Subplan>> scans(queries.size());
+
+  for (unsigned q = 0; q < queries.size(); q++)
+  {
+    for (auto& f : queries[q].filters)
+    {
+      unsigned binding = f.filterColumn.binding;
+
+      if (covered[q][binding])
+        continue;
+
+      covered[q][binding] = true;
+
+      scans[q].push_back(Subplan{ scanKey(queries[q], binding), { binding } });
+    }
+  }
+
+  keepShared(scans);
+
+
+  // Run each shared subplan once, all of them in parallel
+
+  unordered_map<string, future<shared_ptr<const SharedResult>>> runs;
+
+  for (unsigned q = 0; q < queries.size(); q++)
+  {
+    for (auto& subplan : chosen[q])
+    {
+      if (!runs.count(subplan.key))
+        runs.emplace(subplan.key, threadpool.Request([this, &queries, q, &subplan]() { return runSharedSubplan(queries[q], subplan.bindings); }));
+    }
+  }
+
+  unordered_map<string, shared_ptr<const SharedResult>> results;
+
+  for (auto& run : runs)
+    results[run.first] = threadpool.RequestGet(move(run.second));
+
+
+  // Then run the queries with the shared results
+
+  vector<future<string>> outputs;
+
+  for (unsigned q = 0; q < queries.size(); q++)
+  {
+    vector<SharedInput> sharedInputs;
+
+    for (auto& subplan : chosen[q])
+      sharedInputs.push_back(SharedInput{ subplan.bindings, results[subplan.key] });
+
+    // The shared results are released in the work, before its output is ready
+
+    outputs.push_back(threadpool.Request([this, &queries, q, sharedInputs]() mutable {
+      auto inputs = move(sharedInputs);
+
+      return join(queries[q], inputs);
+    }));
+  }
+
+  results.clear();
+
+  vector<string> answers;
+
+  for (auto& output : outputs)
+    answers.push_back(threadpool.RequestGet(move(output)));
+
+  return answers;
+}
+#endif
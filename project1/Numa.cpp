@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Numa.hpp"
+
+
+using namespace std;
+
+
+// The node of this thread, -1 if it is not pinned
+static thread_local int local_node = -1;
+
+
+// The nodes that have cpus
+struct Topology
+{
+  /// The id of each node in the kernel and its cpus, ordered by the id
+  /// The ids may have gaps, the index of a node is used everywhere else
+  vector<pair<unsigned, vector<unsigned>>> nodes;
+
+  Topology()
+  {
+    DIR* dir = opendir("/sys/devices/system/node");
+
+    if (!dir)
+      return;
+
+    while (dirent* entry = readdir(dir))
+    {
+      string name = entry->d_name;
+
+      if (name.compare(0, 4, "node") != 0 || name.size() == 4 || !isdigit(name[4]))
+        continue;
+
+      ifstream in("/sys/devices/system/node/" + name + "/cpulist");
+
+      string list;
+
+      if (!getline(in, list))
+        continue;
+
+      vector<unsigned> cpus = parseList(list);
+
+      if (!cpus.empty())
+        nodes.emplace_back(stoul(name.substr(4)), move(cpus));
+    }
+
+    closedir(dir);
+
+    sort(nodes.begin(), nodes.end());
+  }
+
+  /// Parse the cpu list like "0-3,8-11"
+  static vector<unsigned> parseList(const string& list)
+  {
+    vector<unsigned> result;
+
+    size_t pos = 0;
+
+    while (pos < list.size() && isdigit(list[pos]))
+    {
+      size_t next;
+
+      unsigned first = stoul(list.substr(pos), &next);
+
+      unsigned last = first;
+
+      pos += next;
+
+      if (pos < list.size() && list[pos] == '-')
+      {
+        last = stoul(list.substr(pos + 1), &next);
+
+        pos += next + 1;
+      }
+
+      for (unsigned cpu = first; cpu <= last; cpu++)
+        result.push_back(cpu);
+
+      if (pos < list.size() && list[pos] == ',')
+        pos++;
+    }
+
+    return result;
+  }
+};
+
+static const Topology& topology()
+{
+  static const Topology topology;
+
+  return topology;
+}
+
+
+// The number of the nodes that have cpus, 1 if the topology is unknown
+unsigned Numa::NodeCount()
+{
+  static const unsigned nodeCnt = max<size_t>(topology().nodes.size(), 1);
+
+  return nodeCnt;
+}
+
+// The node of this thread, 0 if it is not pinned
+unsigned Numa::LocalNode()
+{
+  return local_node < 0 ? 0 : local_node;
+}
+
+// Pin this thread to the cpus of the node
+void Numa::PinThread(unsigned node)
+{
+  local_node = node;
+
+  if (NodeCount() == 1)
+    return;
+
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+
+  for (unsigned cpu : topology().nodes[node].second)
+    CPU_SET(cpu, &set);
+
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Bind the pages of [addr, addr + length) to the node
+void Numa::Bind(void* addr, uint64_t length, unsigned node)
+{
+  if (NodeCount() == 1 || length == 0)
+    return;
+
+
+  // The range is extended to the whole pages, the kernel rounds up the length
+
+  uint64_t pageSize = sysconf(_SC_PAGESIZE);
+
+  uint64_t begin = reinterpret_cast<uint64_t>(addr) & ~(pageSize - 1);
+
+  uint64_t end = reinterpret_cast<uint64_t>(addr) + length;
+
+  unsigned nodeId = topology().nodes[node].first;
+
+  constexpr unsigned BITS = sizeof(unsigned long) * 8;
+
+  vector<unsigned long> mask(nodeId / BITS + 1, 0);
+
+  mask[nodeId / BITS] |= 1ul << (nodeId % BITS);
+
+
+  // The kernel reads one less bit than the max node
+
+  syscall(SYS_mbind, begin, end - begin, MPOL_BIND, mask.data(), mask.size() * BITS + 1, 0);
+}
+
+
+// Map the length bytes, on huge pages if the kernel has them
+NodeMemory::NodeMemory(uint64_t length) : length(length)
+{
+  void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (memory == MAP_FAILED)
+    return;
+
+  madvise(memory, length, MADV_HUGEPAGE);
+
+  addr = static_cast<char*>(memory);
+}
+
+NodeMemory& NodeMemory::operator=(NodeMemory&& other) noexcept
+{
+  if (this != &other)
+  {
+    if (addr)
+      munmap(addr, length);
+
+    addr = other.addr;
+
+    length = other.length;
+
+    other.addr = nullptr;
+  }
+
+  return *this;
+}
+
+NodeMemory::~NodeMemory()
+{
+  if (addr)
+    munmap(addr, length);
+}
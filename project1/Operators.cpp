@@ -0,0 +1,2295 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+
+#include "Executeoptions.hpp"
+#include "BloomFilter.hpp"
+#include "Numa.hpp"
+#include "Operators.hpp"
+#include "Reduction.hpp"
+#include "Selection.hpp"
+#include "Threadpool.hpp"
+
+
+using namespace std;
+
+
+extern ThreadPool threadpool;
+
+constexpr unsigned PROBE_COUNT_MAX = 20;
+
+constexpr unsigned SMALL_RESULT_SIZE = 10000;
+
+constexpr uint64_t PARTITION_BUILD_MIN = 1 << 16; // Smaller build side is built serially into one table
+
+constexpr uint64_t PARTITION_SIZE = 1 << 14;      // Expected entries of one partition, so its table fits in the L2 cache
+
+constexpr unsigned RADIX_BITS_MAX = 10;
+
+constexpr uint64_t MORSEL_SIZE = 1 << 14;
+
+constexpr uint64_t PIPELINE_BUILD_MAX = 1 << 18; // Larger build side is compared with the materialized probe side
+
+constexpr uint64_t BLOOM_BUILD_MAX = 1 << 22;    // Larger input does not make the bloom filter for the other input
+
+constexpr uint64_t MORSEL_SIZE_MIN = 1 << 10;
+
+constexpr uint64_t MORSEL_SIZE_MAX = 1 << 16;
+
+constexpr uint64_t MORSEL_TIME = 200000;         // Target time of one morsel in nanoseconds
+
+constexpr uint64_t MORSELS_PER_WORKER = 4;       // Give each worker several morsels, so the fast workers can take more
+
+
+#ifdef MULTI_THREAD_MODE
+// Measured cost of one tuple in picoseconds, for each kind of operators
+// Start from 10ns, then follow the recent runs
+
+static std::atomic<uint64_t> filterTupleCost = 10000;
+
+static std::atomic<uint64_t> joinTupleCost = 10000;
+
+static std::atomic<uint64_t> selfJoinTupleCost = 10000;
+
+#ifdef INDEX_JOIN_MODE
+static std::atomic<uint64_t> indexJoinTupleCost = 10000;
+#endif
+
+static std::atomic<uint64_t> checksumTupleCost = 10000;
+
+// Morsel-driven parallel execution
+
+// Workers claim the morsels from the shared cursors, so the fast workers take more morsels
+// The morsels are split into the ranges of the NUMA nodes like the rows of the loaded relations,
+// and a worker claims the morsels of its own node first
+// The morsel size is decided by the input size and the measured cost per tuple,
+// so a morsel takes about MORSEL_TIME and each worker gets several morsels
+// Small input is processed by this thread alone, without requesting any work
+
+struct MorselPlan
+{
+  uint64_t size;
+
+  uint64_t morsel_size;
+
+  uint64_t morsel_cnt;
+
+  uint64_t worker_cnt;
+};
+
+// Decide the morsel size and the number of workers
+static MorselPlan planMorsels(uint64_t size, std::atomic<uint64_t>& tupleCost)
+{
+  uint64_t worker_cnt = threadpool.Size() + 1; // This thread works too
+
+  uint64_t morsel_size = MORSEL_TIME * 1000 / std::max<uint64_t>(tupleCost.load(std::memory_order_relaxed), 1);
+
+  morsel_size = std::min(morsel_size, (size + worker_cnt * MORSELS_PER_WORKER - 1) / (worker_cnt * MORSELS_PER_WORKER));
+
+  morsel_size = std::clamp(morsel_size, MORSEL_SIZE_MIN, MORSEL_SIZE_MAX);
+
+  uint64_t morsel_cnt = (size + morsel_size - 1) / morsel_size;
+
+  return MorselPlan{ size, morsel_size, morsel_cnt, std::min(worker_cnt, morsel_cnt) };
+}
+
+// Run the work(worker, morsel, start, end) over the morsels of the plan
+// Then update the cost per tuple with this run, and the probe of the profile
+static void runMorsels(const MorselPlan& plan, std::atomic<uint64_t>& tupleCost, OperatorProfile& profile, const std::function<void(uint64_t, uint64_t, uint64_t, uint64_t)>& work)
+{
+  WallTimer timer(profile.probeWallNs);
+
+  if (Explain::On())
+    profile.tasks += plan.morsel_cnt;
+
+  NodeCursors cursors(plan.morsel_cnt);
+
+  std::atomic<uint64_t> elapsed = 0;
+
+  auto worker = [&](uint64_t worker)
+                {
+                  CpuTimer cpuTimer(profile.probeCpuNs);
+
+                  auto begin = std::chrono::steady_clock::now();
+
+                  uint64_t morsel;
+
+                  while (cursors.Next(morsel))
+                  {
+                    uint64_t start = morsel * plan.morsel_size;
+
+                    work(worker, morsel, start, std::min(start + plan.morsel_size, plan.size));
+                  }
+
+                  elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+                };
+
+  std::vector<std::future<void>> worker_list;
+
+  for (uint64_t i = 1; i < plan.worker_cnt; i++)
+    worker_list.push_back(threadpool.Request(worker, i));
+
+  worker(0);
+
+  for (auto& worker_unit : worker_list)
+    threadpool.RequestWait(std::move(worker_unit));
+
+  if (plan.size >= MORSEL_SIZE_MIN)
+    tupleCost.store((tupleCost.load(std::memory_order_relaxed) + elapsed.load() * 1000 / plan.size) / 2, std::memory_order_relaxed);
+}
+
+// Run the probe over [0, size) morsel by morsel, and materialize its results
+// Return the number of result tuples
+
+// The result of each morsel is kept separately in the arena, then combined in the order of morsels
+static uint64_t materializeMorsels(Arena* arena, uint64_t size, std::atomic<uint64_t>& tupleCost, OperatorProfile& profile, std::vector<uint64_t*>& results, 
+                                   const std::function<uint64_t(uint64_t, uint64_t, TmpResult&)>& probe)
+{
+  MorselPlan plan = planMorsels(size, tupleCost);
+
+  uint64_t morsel_cnt = plan.morsel_cnt;
+
+
+  // Probe
+
+  std::vector<TmpResult> morsel_results(morsel_cnt);
+
+  std::vector<uint64_t> morsel_sizes(morsel_cnt, 0);
+
+  runMorsels(plan, tupleCost, profile, [&](uint64_t worker, uint64_t morsel, uint64_t start, uint64_t end)
+                                       {
+                                         TmpResult& tmpResult = morsel_results[morsel];
+
+                                         tmpResult.assign(results.size(), ArenaVector<uint64_t>(ArenaAllocator<uint64_t>(arena)));
+
+                                         morsel_sizes[morsel] = probe(start, end, tmpResult);
+                                       });
+
+
+  // Before combining, make space for elements
+
+  std::vector<uint64_t> offsets(morsel_cnt + 1, 0);
+
+  for (uint64_t i = 0; i < morsel_cnt; i++)
+    offsets[i + 1] = offsets[i] + morsel_sizes[i];
+
+  uint64_t total = offsets[morsel_cnt];
+
+  for (auto& col : results)
+    col = arena ? arena->Allocate<uint64_t>(total) : new uint64_t[total];
+
+  if (Explain::On())
+    profile.bytesMaterialized += total * results.size() * sizeof(uint64_t);
+
+
+  // Combine the results of morsels
+  // If the results are small, just combine them now
+
+  std::atomic<uint64_t> combine_cursor = 0;
+
+  auto combine = [&]()
+                 {
+                   uint64_t morsel;
+
+                   while ((morsel = combine_cursor.fetch_add(1)) < morsel_cnt)
+                   {
+                     TmpResult& tmpResult = morsel_results[morsel];
+
+                     for (unsigned colId = 0; colId < results.size(); colId++)
+                       memcpy(results[colId] + offsets[morsel], tmpResult[colId].data(), sizeof(uint64_t) * morsel_sizes[morsel]);
+
+                     TmpResult().swap(tmpResult);
+                   }
+                 };
+
+  uint64_t combine_cnt = total * results.size() < SMALL_RESULT_SIZE ? 1 : plan.worker_cnt;
+
+  std::vector<std::future<void>> combine_list;
+
+  for (uint64_t i = 1; i < combine_cnt; i++)
+    combine_list.push_back(threadpool.Request(combine));
+
+  combine();
+
+  for (auto& combine_unit : combine_list)
+    threadpool.RequestWait(std::move(combine_unit));
+
+  return total;
+}
+
+// Run the probe over [0, size) morsel by morsel, and add the sums of its results to the sums
+// Return the number of result tuples
+
+// Each worker has its own partial sums, then they are merged
+static uint64_t sumMorsels(uint64_t size, std::atomic<uint64_t>& tupleCost, OperatorProfile& profile, std::vector<uint64_t>& sums, 
+                           const std::function<uint64_t(uint64_t, uint64_t, std::vector<uint64_t>&)>& probe)
+{
+  MorselPlan plan = planMorsels(size, tupleCost);
+
+  std::vector<std::vector<uint64_t>> partial_sums(plan.worker_cnt, std::vector<uint64_t>(sums.size(), 0));
+
+  std::vector<uint64_t> partial_sizes(plan.worker_cnt, 0);
+
+  runMorsels(plan, tupleCost, profile, [&](uint64_t worker, uint64_t morsel, uint64_t start, uint64_t end)
+                                       {
+                                         partial_sizes[worker] += probe(start, end, partial_sums[worker]);
+                                       });
+
+  uint64_t total = 0;
+
+  for (uint64_t worker = 0; worker < plan.worker_cnt; worker++)
+  {
+    for (unsigned i = 0; i < sums.size(); i++)
+      sums[i] += partial_sums[worker][i];
+
+    total += partial_sizes[worker];
+  }
+
+  return total;
+}
+#endif
+
+// Add the sums of the columns over the tuples [start, end) to sums
+// The rows are summed block by block for all the columns, so the shared row ids of a binding stay in the cache
+static void sumColumns(const std::vector<ColumnRef>& cols, uint64_t start, uint64_t end, uint64_t* sums)
+{
+  for (uint64_t blockStart = start; blockStart < end; blockStart += Reduction::BLOCK_SIZE)
+  {
+    uint32_t count = std::min<uint64_t>(Reduction::BLOCK_SIZE, end - blockStart);
+
+    for (unsigned i = 0; i < cols.size(); i++)
+    {
+      const ColumnRef& col = cols[i];
+
+      sums[i] += col.rowIds ? Reduction::Sum(col.base, col.rowIds + blockStart, count) : Reduction::Sum(col.base + blockStart, nullptr, count);
+    }
+  }
+}
+
+// Get the contiguous keys of the column
+// If the column has row ids, gather the keys into the arena, or the storage if there is no arena
+static uint64_t* gatherKeys(Arena* arena, ColumnRef& keys, uint64_t size, std::unique_ptr<uint64_t[]>& storage)
+{
+  if (!keys.rowIds)
+    return keys.base;
+
+  uint64_t* gathered = arena ? arena->Allocate<uint64_t>(size) : (storage.reset(new uint64_t[size]), storage.get());
+
+  for (uint64_t i = 0; i < size; i++)
+    gathered[i] = keys[i];
+
+  return gathered;
+}
+
+// Require a column and add it to results
+bool Scan::require(SelectInfo info)
+{
+  // Check required relation is same with this scanning operator's relation
+
+  if (info.binding != relationBinding)
+    return false;
+
+  assert(info.colId < relation.columns.size());
+
+#ifdef MULTI_THREAD_MODE
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+    
+  resultColumns.push_back(relation.columns[info.colId]);  // Store starting address of required column
+
+  resultRefs.push_back(ColumnRef{ relation.columns[info.colId], nullptr });
+    
+  select2ResultColId[info] = resultColumns.size() - 1;    // Store index of resultColumns. If there are duplicated columns, last pushed index will be stored
+
+  return true;
+}
+
+// Run
+void Scan::run()
+{
+  // Nothing to do
+  resultSize = relation.size;
+}
+
+// Get materialized results
+vector<uint64_t*> Scan::getResults()
+{
+  return resultColumns;
+}
+
+#ifdef PIPELINE_MODE
+// Produce the result of the source tuples [start, end) into the morsel
+void Scan::produce(uint64_t start, uint64_t end, Morsel& morsel)
+{
+  // The columns of the relation can be used directly, no copy
+
+  morsel.size = end - start;
+
+  morsel.columns.clear();
+
+  for (auto col : resultColumns)
+    morsel.columns.push_back(col + start);
+
+  if (Explain::On())
+    profile.producedSize += morsel.size;
+}
+#endif
+
+// The constructor
+FilterScan::FilterScan(Relation& r, std::vector<FilterInfo> filters) : Scan(r, filters[0].filterColumn.binding), filters(filters)
+#ifdef COMPRESSION_MODE
+  , firstCodeFilter(filters[0])
+#endif
+{
+#ifdef COMPRESSION_MODE
+  // The first filter scans the blocks densely, so make it the filter on a compressed column if there is
+  // Then it compares the codes instead of the values
+
+  for (auto& f : this->filters)
+  {
+    unsigned colId = f.filterColumn.colId;
+
+    if (colId < relation.compressedColumns.size() && relation.compressedColumns[colId].Compressed())
+    {
+      std::swap(f, this->filters[0]);
+
+      firstCodes = &relation.compressedColumns[colId];
+
+      firstCodeFilter = firstCodes->TranslateFilter(this->filters[0]);
+
+      break;
+    }
+  }
+#endif
+}
+
+// Require a column and add it to results
+bool FilterScan::require(SelectInfo info)
+{
+  // Check required relation is same with this filtering operator's relation
+
+  if (info.binding != relationBinding)
+    return false;
+
+  assert(info.colId < relation.columns.size());
+
+#ifdef MULTI_THREAD_MODE
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+
+  // If requiring column id is not exist in result yet
+
+  if (select2ResultColId.find(info) == select2ResultColId.end()) 
+  {
+    // Add to results
+
+    inputData.push_back(relation.columns[info.colId]);
+    
+    tmpResults.emplace_back();
+    
+    unsigned colId = tmpResults.size() - 1;
+    
+    select2ResultColId[info] = colId;
+  } 
+
+  return true;
+}
+
+// Match the zone with the filters by the smallest and the largest values of the filtered columns
+// The zone is None if a filter can not pass any tuple, All if every filter passes every tuple
+FilterScan::ZoneMatch FilterScan::matchZone(uint64_t zone)
+{
+  bool all = bloomFilters.empty();  // The bloom filters are always tested
+
+  for (auto& f : filters)
+  {
+    auto& zoneMap = relation.zoneMaps[f.filterColumn.colId];
+
+    uint64_t min = zoneMap.mins[zone], max = zoneMap.maxs[zone];
+
+    switch (f.comparison)
+    {
+      case FilterInfo::Comparison::Equal:
+        if (f.constant < min || f.constant > max)
+          return ZoneMatch::None;
+
+        all = all && min == max;
+        break;
+
+      case FilterInfo::Comparison::Greater:
+        if (max <= f.constant)
+          return ZoneMatch::None;
+
+        all = all && min > f.constant;
+        break;
+
+      case FilterInfo::Comparison::Less:
+        if (min >= f.constant)
+          return ZoneMatch::None;
+
+        all = all && max < f.constant;
+        break;
+    }
+  }
+
+  return all ? ZoneMatch::All : ZoneMatch::Some;
+}
+
+// Select the tuples of the block [start, start + count) which pass all filters
+uint32_t FilterScan::selectBlock(uint64_t start, uint32_t count, uint32_t* sel)
+{
+  // The first filter scans the block, the others only check the selected tuples
+  // If its column is compressed, the codes of the block are widened and compared
+
+  auto& first = filters[0];
+
+  uint32_t selCount;
+
+#ifdef COMPRESSION_MODE
+  uint64_t codes[Selection::BLOCK_SIZE];
+
+  if (firstCodes)
+  {
+    firstCodes->DecodeCodes(start, count, codes);
+
+    selCount = Selection::Select(codes, count, firstCodeFilter.comparison, firstCodeFilter.constant, sel);
+  }
+  else
+#endif
+  selCount = Selection::Select(relation.columns[first.filterColumn.colId] + start, count, first.comparison, first.constant, sel);
+
+  for (unsigned fId = 1; fId < filters.size() && selCount; fId++)
+  {
+    auto& f = filters[fId];
+
+    selCount = Selection::Refine(relation.columns[f.filterColumn.colId] + start, f.comparison, f.constant, sel, selCount);
+  }
+
+
+  // Then drop the tuples which can not have a partner in the joins above
+
+  for (unsigned bId = 0; bId < bloomFilters.size() && selCount; bId++)
+  {
+    auto col = relation.columns[bloomFilters[bId].first] + start;
+
+    auto& bloomFilter = *bloomFilters[bId].second;
+
+    uint32_t remain = 0;
+
+    for (uint32_t i = 0; i < selCount; i++)
+    {
+      uint32_t offset = sel[i];
+
+      sel[remain] = offset;
+
+      remain += bloomFilter.Contains(col[offset]);
+    }
+
+    selCount = remain;
+  }
+
+  return selCount;
+}
+
+// Copy the selected tuples of the block to result
+void FilterScan::copy2Result(uint64_t start, const uint32_t* sel, uint32_t selCount, TmpResult& tmpResult)
+{
+  for (unsigned cId = 0; cId < inputData.size(); cId++)
+  {
+    auto col = inputData[cId] + start;  // inputData is a vector that stores column's starting address
+
+    auto& result = tmpResult[cId];
+
+    size_t offset = result.size();
+
+    result.resize(offset + selCount);
+
+    uint64_t* out = result.data() + offset;
+
+    for (uint32_t i = 0; i < selCount; i++)
+      out[i] = col[sel[i]];
+  }
+}
+
+// Copy the row ids of the selected tuples of the block to result
+void FilterScan::copyRowIds2Result(uint64_t start, const uint32_t* sel, uint32_t selCount, TmpResult& tmpResult)
+{
+  auto& result = tmpResult[0];
+
+  size_t offset = result.size();
+
+  result.resize(offset + selCount);
+
+  uint64_t* out = result.data() + offset;
+
+  for (uint32_t i = 0; i < selCount; i++)
+    out[i] = start + sel[i];
+}
+
+// Copy all tuples [start, end) to result
+void FilterScan::copyRange2Result(uint64_t start, uint64_t end, TmpResult& tmpResult)
+{
+  for (unsigned cId = 0; cId < inputData.size(); cId++)
+    tmpResult[cId].insert(tmpResult[cId].end(), inputData[cId] + start, inputData[cId] + end);
+}
+
+// Copy the row ids of all tuples [start, end) to result
+void FilterScan::copyRangeRowIds2Result(uint64_t start, uint64_t end, TmpResult& tmpResult)
+{
+  auto& result = tmpResult[0];
+
+  size_t offset = result.size();
+
+  result.resize(offset + (end - start));
+
+  uint64_t* out = result.data() + offset;
+
+  for (uint64_t rowId = start; rowId < end; rowId++)
+    *out++ = rowId;
+}
+
+// Filter the tuples [start, end) block by block, and copy the passed tuples (or their row ids) to result
+// Return the number of passed tuples
+uint64_t FilterScan::filter(uint64_t start, uint64_t end, TmpResult& tmpResult, bool copyRowIds)
+{
+  uint32_t sel[Selection::BLOCK_SIZE];
+
+  uint64_t passed = 0;
+
+  bool hasZoneMaps = !relation.zoneMaps.empty();
+
+  for (uint64_t zoneStart = start; zoneStart < end;)
+  {
+    // The zone maps tell whether the tuples of the zone need to be tested
+    // The zones no tuple passes are skipped, and the zones all tuples pass are copied as they are
+
+    uint64_t zoneEnd = hasZoneMaps ? std::min(end, (zoneStart / ZONE_SIZE + 1) * ZONE_SIZE) : end;
+
+    ZoneMatch match = hasZoneMaps ? matchZone(zoneStart / ZONE_SIZE) : ZoneMatch::Some;
+
+    if (match == ZoneMatch::All)
+    {
+      if (copyRowIds)
+        copyRangeRowIds2Result(zoneStart, zoneEnd, tmpResult);
+      else
+        copyRange2Result(zoneStart, zoneEnd, tmpResult);
+
+      passed += zoneEnd - zoneStart;
+    }
+    else if (match == ZoneMatch::Some)
+    {
+      for (uint64_t blockStart = zoneStart; blockStart < zoneEnd; blockStart += Selection::BLOCK_SIZE)
+      {
+        uint32_t count = std::min<uint64_t>(Selection::BLOCK_SIZE, zoneEnd - blockStart);
+
+        uint32_t selCount = selectBlock(blockStart, count, sel);
+
+        if (selCount == 0)
+          continue;
+
+        if (copyRowIds)
+          copyRowIds2Result(blockStart, sel, selCount, tmpResult);
+        else
+          copy2Result(blockStart, sel, selCount, tmpResult);
+
+        passed += selCount;
+      }
+    }
+
+    zoneStart = zoneEnd;
+  }
+
+  return passed;
+}
+
+// Run
+void FilterScan::run()
+{
+  WallTimer timer(profile.wallNs);
+
+#ifdef SINGLE_THREAD_MODE
+  resultSize = filter(0, relation.size, tmpResults, false);
+#endif
+#ifdef MULTI_THREAD_MODE
+
+  // The columns to materialize
+  // In late materialization mode, they are the row id columns of the bindings
+
+#ifdef LATE_MATERIALIZATION_MODE
+  rowIdResults.assign(1, nullptr);
+
+  std::vector<uint64_t*>& results = rowIdResults;
+#else
+  std::vector<uint64_t*>& results = tmpResults;
+#endif
+
+  // Filter the relation morsel by morsel
+
+  uint64_t size = materializeMorsels(arena, relation.size, filterTupleCost, profile, results, 
+                                     [this](uint64_t start, uint64_t end, TmpResult& tmpResult)
+                                     {
+#ifdef LATE_MATERIALIZATION_MODE
+                                       return filter(start, end, tmpResult, true);
+#else
+                                       return filter(start, end, tmpResult, false);
+#endif
+                                     });
+
+
+  resultSize = size;
+
+#endif
+
+
+  // Refer the results
+
+#ifdef LATE_MATERIALIZATION_MODE
+  for (auto col : inputData)
+    resultRefs.push_back(ColumnRef{ col, rowIdResults[0] });
+#else
+  referResults();
+#endif
+}
+
+// The name and the arguments of this operator, for the explain
+std::string FilterScan::explainName()
+{
+  std::string name = "FilterScan " + std::to_string(relationBinding);
+
+  for (unsigned i = 0; i < filters.size(); i++)
+    name += (i == 0 ? " " : "&") + filters[i].dumpText();
+
+  return name;
+}
+
+#ifdef PIPELINE_MODE
+// Produce the result of the source tuples [start, end) into the morsel
+void FilterScan::produce(uint64_t start, uint64_t end, Morsel& morsel)
+{
+  morsel.clear(inputData.size());
+
+  morsel.size = filter(start, end, morsel.buffers, false);
+
+  morsel.seal();
+
+  if (Explain::On())
+    profile.producedSize += morsel.size;
+}
+#endif
+
+#ifdef SHARED_SUBPLAN_MODE
+// Require a column and add it to results
+bool SharedScan::require(SelectInfo info)
+{
+  auto binding = std::find(bindings.begin(), bindings.end(), info.binding);
+
+  if (binding == bindings.end())
+    return false;
+
+  unsigned r = binding - bindings.begin();
+
+  assert(info.colId < relations[r]->columns.size());
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (select2ResultColId.find(info) == select2ResultColId.end())
+  {
+    resultRefs.push_back(ColumnRef{ relations[r]->columns[info.colId], nullptr });
+
+    resultRelations.push_back(r);
+
+    select2ResultColId[info] = resultRefs.size() - 1;
+  }
+
+  return true;
+}
+
+// The name and the arguments of this operator, for the explain
+std::string SharedScan::explainName()
+{
+  std::string name = "SharedScan";
+
+  for (unsigned i = 0; i < bindings.size(); i++)
+    name += (i == 0 ? " " : ",") + std::to_string(bindings[i]);
+
+  return name;
+}
+
+// Run
+void SharedScan::run()
+{
+  WallTimer timer(profile.wallNs);
+
+  // The subplan is already done, refer its row ids
+
+  resultSize = shared->size;
+
+  for (unsigned cId = 0; cId < resultRefs.size(); cId++)
+    resultRefs[cId].rowIds = shared->rowIds[resultRelations[cId]];
+}
+#endif
+
+// Get materialized results
+vector<uint64_t*> Operator::getResults()
+{
+#ifdef LATE_MATERIALIZATION_MODE
+  // The results have only row ids, so gather the values of required columns
+
+  if (gatheredResults.empty())
+  {
+    for (auto& ref : resultRefs)
+    {
+      uint64_t* col = allocateColumn(resultSize);
+
+      for (uint64_t i = 0; i < resultSize; i++)
+        col[i] = ref[i];
+
+      gatheredResults.push_back(col);
+    }
+  }
+
+  return gatheredResults;
+#endif
+
+  vector<uint64_t*> resultVector;
+
+  for (auto& c : tmpResults) 
+  {
+#ifdef SINGLE_THREAD_MODE
+    resultVector.push_back(c.data()); // Push temporal columns's starting address
+#endif
+#ifdef MULTI_THREAD_MODE
+    resultVector.push_back(c);
+#endif
+  }
+  
+  return resultVector;
+}
+
+// Refer the materialized values as the results
+void Operator::referResults()
+{
+  resultRefs.clear();
+
+  for (auto& c : tmpResults) 
+  {
+#ifdef SINGLE_THREAD_MODE
+    resultRefs.push_back(ColumnRef{ c.data(), nullptr });
+#endif
+#ifdef MULTI_THREAD_MODE
+    resultRefs.push_back(ColumnRef{ c, nullptr });
+#endif
+  }
+}
+
+// Require a column and add it to results
+bool Join::require(SelectInfo info)
+{
+  // Projection pushdown
+  // "info" is the required projection. Push it to the left or right
+
+#ifdef SINGLE_THREAD_MODE
+  if (requestedColumns.count(info) == 0) 
+  {
+    bool success = false;
+    
+    if (left->require(info))
+    {
+      requestedColumnsLeft.emplace_back(info);
+        
+      success = true;
+    } 
+    else if (right->require(info)) 
+    {
+      requestedColumnsRight.emplace_back(info);
+        
+      success = true;
+    }
+
+
+    if (!success)
+    {
+      return false;
+    }
+
+
+    tmpResults.emplace_back();
+      
+    requestedColumns.emplace(info);
+  }
+
+  return true;
+#endif
+#ifdef MULTI_THREAD_MODE
+  if (requestedColumns.count(info))
+    return true;
+
+  if (left->require(info))
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (requestedColumns.count(info) == 0)
+    {
+      requestedColumnsLeft.emplace_back(info);
+
+      tmpResults.emplace_back();
+        
+      requestedColumns.emplace(info);
+    }
+    
+    return true;
+  } 
+  else if (right->require(info)) 
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (requestedColumns.count(info) == 0)
+    {
+      requestedColumnsRight.emplace_back(info);
+
+      tmpResults.emplace_back();
+        
+      requestedColumns.emplace(info);      
+    }
+    
+    return true;
+  }
+
+  return false;
+#endif
+}
+
+#ifdef SINGLE_THREAD_MODE
+// Copy to result
+void Join::copy2Result(uint64_t leftId, uint64_t rightId)
+{
+  unsigned relColId = 0;
+
+  for (unsigned cId = 0; cId < copyLeftData.size(); cId++)
+    tmpResults[relColId++].push_back(copyLeftData[cId][leftId]);
+
+  for (unsigned cId = 0; cId < copyRightData.size(); cId++)
+    tmpResults[relColId++].push_back(copyRightData[cId][rightId]);
+  
+  ++resultSize;
+}
+#endif
+#ifdef MULTI_THREAD_MODE
+// Copy to result
+inline void Join::copy2Result(uint64_t leftId, uint64_t rightId, TmpResult& tmpResult)
+{
+  unsigned relColId = 0;
+
+  for (unsigned cId = 0; cId < copyLeftData.size(); cId++)
+    tmpResult[relColId++].push_back(copyLeftData[cId][leftId]);
+
+  for (unsigned cId = 0; cId < copyRightData.size(); cId++)
+    tmpResult[relColId++].push_back(copyRightData[cId][rightId]);
+
+}
+#endif
+#ifdef LATE_MATERIALIZATION_MODE
+// Copy row ids of tuple to result
+inline void Join::copyRowIds2Result(uint64_t leftId, uint64_t rightId, TmpResult& tmpResult)
+{
+  unsigned relColId = 0;
+
+  for (auto rowIds : copyLeftRowIds)
+    tmpResult[relColId++].push_back(rowIds ? rowIds[leftId] : leftId);
+
+  for (auto rowIds : copyRightRowIds)
+    tmpResult[relColId++].push_back(rowIds ? rowIds[rightId] : rightId);
+}
+#endif
+
+// Run the inputs one by one, and pass the bloom filter of the first one's keys to the FilterScan below the other
+bool Join::runWithBloomFilter()
+{
+  FilterScan* leftTarget = left->findFilterScan(pInfo.left.binding);
+
+  FilterScan* rightTarget = right->findFilterScan(pInfo.right.binding);
+
+  if (!leftTarget && !rightTarget)
+    return false;
+
+
+  // Choose the input that receives the filter, it runs later
+  // Prefer the FilterScan that is the input itself, it is the new relation of the left-deep tree
+  // If both inputs are FilterScans, the larger relation receives the filter
+
+  bool filterLeft;
+
+  if (!leftTarget || !rightTarget)
+    filterLeft = leftTarget;
+  else if ((leftTarget == left.get()) != (rightTarget == right.get()))
+    filterLeft = leftTarget == left.get();
+  else if (leftTarget == left.get())
+    filterLeft = leftTarget->relationSize() > rightTarget->relationSize();
+  else
+    filterLeft = false;
+
+
+  // Run the first input, then build the bloom filter with its keys
+  // Then run the other input with the filter
+
+  if (filterLeft)
+  {
+    right->run();
+
+    pushBloomFilter(*right, pInfo.right, leftTarget, pInfo.left);
+
+    left->run();
+  }
+  else
+  {
+    left->run();
+
+    pushBloomFilter(*left, pInfo.left, rightTarget, pInfo.right);
+
+    right->run();
+  }
+
+  return true;
+}
+
+// Build the bloom filter of the keys of the input, then push it down to the target
+void Join::pushBloomFilter(Operator& input, SelectInfo& key, FilterScan* target, SelectInfo& targetKey)
+{
+  // If the input is not smaller than the target relation, the filter can not drop many tuples
+
+  if (input.resultSize > BLOOM_BUILD_MAX || input.resultSize >= target->relationSize())
+    return;
+
+  auto bloomFilter = std::make_shared<BloomFilter>(input.resultSize);
+
+  ColumnRef keys = input.getColumn(key);
+
+  for (uint64_t i = 0; i < input.resultSize; i++)
+    bloomFilter->Insert(keys[i]);
+
+  target->addBloomFilter(targetKey.colId, bloomFilter);
+}
+
+// Run
+void Join::run()
+{
+  WallTimer timer(profile.wallNs);
+
+  // Pushdown projections
+
+  left->require(pInfo.left);
+
+  right->require(pInfo.right);
+
+
+  // Execute the operators below
+  // If the bloom filter can be passed, the inputs run one by one
+
+#ifdef SINGLE_THREAD_MODE
+  if (!runWithBloomFilter())
+  {
+    left->run();
+  
+    right->run();
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+  // The left input runs in the pool, and this thread continues with the right input instead of waiting
+  // If no worker has taken the left input by then, this thread runs it too
+
+  if (!runWithBloomFilter())
+  {
+    auto left_run = threadpool.Request([this]() { left->run(); });
+
+    right->run();
+
+    threadpool.RequestWait(std::move(left_run));
+  }
+#endif
+
+
+  // Use smaller input for build
+
+  if (left->resultSize > right->resultSize) 
+  {
+    swap(left, right);
+  
+    swap(pInfo.left, pInfo.right);
+  
+    swap(requestedColumnsLeft, requestedColumnsRight);
+  }
+
+
+
+  // Resolve the input columns
+
+  unsigned resColId = 0;
+
+#ifdef LATE_MATERIALIZATION_MODE
+  // Copy the row ids of each bindings instead of the values
+  // The results refer the base columns through the copied row ids
+
+  std::unordered_map<unsigned, unsigned> binding2RowIdColId;
+
+  std::vector<unsigned> resultRowIdColIds;
+
+  for (auto& info : requestedColumnsLeft) 
+  {
+    ColumnRef ref = left->getColumn(info);
+
+    if (!binding2RowIdColId.count(info.binding))
+    {
+      binding2RowIdColId[info.binding] = copyLeftRowIds.size();
+
+      copyLeftRowIds.push_back(ref.rowIds);
+    }
+
+    resultRefs.push_back(ColumnRef{ ref.base, nullptr });
+
+    resultRowIdColIds.push_back(binding2RowIdColId[info.binding]);
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  for (auto& info : requestedColumnsRight) 
+  {
+    ColumnRef ref = right->getColumn(info);
+
+    if (!binding2RowIdColId.count(info.binding))
+    {
+      binding2RowIdColId[info.binding] = copyLeftRowIds.size() + copyRightRowIds.size();
+
+      copyRightRowIds.push_back(ref.rowIds);
+    }
+
+    resultRefs.push_back(ColumnRef{ ref.base, nullptr });
+
+    resultRowIdColIds.push_back(binding2RowIdColId[info.binding]);
+
+    select2ResultColId[info] = resColId++;
+  }
+#else
+  // Copy the starting address of columns that is requested to the left operator
+
+  for (auto& info : requestedColumnsLeft) 
+  {
+    copyLeftData.push_back(left->getColumn(info).base);
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  // Copy the starting address of columns that is requested to the right operator
+
+  for (auto& info : requestedColumnsRight) 
+  {
+    copyRightData.push_back(right->getColumn(info).base);
+  
+    select2ResultColId[info] = resColId++;
+  }
+#endif
+
+
+  // If the checksum is fused, the sums of the required columns are the results
+
+  if (checksumFused)
+    resultSums.assign(resColId, 0);
+
+
+  // If left or right operator has no results, set the results size 0.
+  // Then exit
+
+  if (left->resultSize == 0 || right->resultSize == 0)
+  {
+    resultSize = 0;
+
+#ifndef LATE_MATERIALIZATION_MODE
+    referResults();
+#endif
+
+    return;
+  }
+
+
+  // To compare columns that are requried for join,
+  // It must be able to access the values of that columns
+
+  auto leftKey = left->getColumn(pInfo.left);
+  
+  auto rightKeyColumn = right->getColumn(pInfo.right);
+
+
+  // Build phase
+  // If the keys are referred through row ids, gather them
+
+  std::unique_ptr<uint64_t[]> gatheredKeys;
+
+  buildHashTable(gatherKeys(arena, leftKey, left->resultSize, gatheredKeys), left->resultSize);
+
+
+  // Probe phase with the fused checksum
+  // Sum the required columns of the matches, the result is not materialized
+
+  if (checksumFused)
+  {
+    std::vector<ColumnRef> sumLeftColumns, sumRightColumns;
+
+    for (auto& info : requestedColumnsLeft)
+      sumLeftColumns.push_back(left->getColumn(info));
+
+    for (auto& info : requestedColumnsRight)
+      sumRightColumns.push_back(right->getColumn(info));
+
+    auto probe = [this, &rightKeyColumn, &sumLeftColumns, &sumRightColumns](uint64_t start, uint64_t end, std::vector<uint64_t>& sums)
+                 {
+                   uint64_t matched = 0;
+
+                   for (uint64_t i = start; i < end; i++)
+                   {
+                     uint64_t count = 0;
+
+                     hashTable.Probe(rightKeyColumn[i], [&sums, &sumLeftColumns, &count](uint64_t leftId)
+                                                        {
+                                                          for (unsigned cId = 0; cId < sumLeftColumns.size(); cId++)
+                                                            sums[cId] += sumLeftColumns[cId][leftId];
+
+                                                          count++;
+                                                        });
+
+                     // The right tuple is in the result once for each match
+
+                     if (count == 0)
+                       continue;
+
+                     for (unsigned cId = 0; cId < sumRightColumns.size(); cId++)
+                       sums[sumLeftColumns.size() + cId] += count * sumRightColumns[cId][i];
+
+                     matched += count;
+                   }
+
+                   return matched;
+                 };
+
+#ifdef SINGLE_THREAD_MODE
+    resultSize = probe(0, right->resultSize, resultSums);
+#endif
+#ifdef MULTI_THREAD_MODE
+    resultSize = sumMorsels(right->resultSize, joinTupleCost, profile, resultSums, probe);
+#endif
+
+    return;
+  }
+
+
+  // Probe phase
+
+#ifdef SINGLE_THREAD_MODE
+  for (uint64_t i = 0, limit = i + right->resultSize; i != limit; i++) 
+  {
+    auto rightKey = rightKeyColumn[i];
+    
+    hashTable.Probe(rightKey, [this, i](uint64_t leftId) { copy2Result(leftId, i); }); // leftId : index of left key value, i : index of right key value
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+
+  // The columns to materialize
+  // In late materialization mode, they are the row id columns of the bindings
+
+#ifdef LATE_MATERIALIZATION_MODE
+  rowIdResults.assign(copyLeftRowIds.size() + copyRightRowIds.size(), nullptr);
+
+  std::vector<uint64_t*>& results = rowIdResults;
+#else
+  std::vector<uint64_t*>& results = tmpResults;
+#endif
+
+  // Probe the hash table morsel by morsel
+
+  uint64_t size = materializeMorsels(arena, right->resultSize, joinTupleCost, profile, results, 
+                                     [this, &rightKeyColumn](uint64_t start, uint64_t end, TmpResult& tmpResult)
+                                     {
+                                       uint64_t matched = 0;
+
+                                       for (uint64_t i = start; i < end; i++)
+                                       {
+                                         auto rightKey = rightKeyColumn[i];
+                        
+#ifdef LATE_MATERIALIZATION_MODE
+                                         hashTable.Probe(rightKey, [this, i, &tmpResult, &matched](uint64_t leftId) { copyRowIds2Result(leftId, i, tmpResult); matched++; }); // leftId : index of left key value, i : index of right key value
+#else
+                                         hashTable.Probe(rightKey, [this, i, &tmpResult, &matched](uint64_t leftId) { copy2Result(leftId, i, tmpResult); matched++; }); // leftId : index of left key value, i : index of right key value
+#endif
+                                       }
+
+                                       return matched;
+                                     });
+
+
+  resultSize = size;
+
+#endif
+
+
+  // Refer the results
+
+#ifdef LATE_MATERIALIZATION_MODE
+  for (unsigned cId = 0; cId < resultRefs.size(); cId++)
+    resultRefs[cId].rowIds = rowIdResults[resultRowIdColIds[cId]];
+#else
+  referResults();
+#endif
+}
+
+#ifdef PIPELINE_MODE
+// Whether the left input has to be streamed, the other side is built
+bool Join::probeLeft()
+{
+  bool leftStreamable = left->streamable();
+
+  bool rightStreamable = right->streamable();
+
+
+  // Only one of them can be streamed
+
+  if (leftStreamable != rightStreamable)
+    return leftStreamable;
+
+
+  // Both of them are base relations, build the smaller one
+
+  if (left->isScan() && right->isScan())
+    return left->sourceSize() > right->sourceSize();
+
+
+  // Otherwise, keep streaming the pipeline below and build the base relation
+
+  return !left->isScan() && right->isScan();
+}
+
+// Prepare the streaming, build the hash table and open the probe side
+void Join::open()
+{
+  WallTimer timer(profile.wallNs);
+
+  // Pushdown projections
+
+  left->require(pInfo.left);
+
+  right->require(pInfo.right);
+
+
+  // The left side is built and the right side is streamed
+
+  if (probeLeft())
+  {
+    swap(left, right);
+  
+    swap(pInfo.left, pInfo.right);
+  
+    swap(requestedColumnsLeft, requestedColumnsRight);
+  }
+
+
+  // Materialize the build side
+  // Then pass the bloom filter of its keys to the FilterScan below the probe side
+
+  left->run();
+
+  if (FilterScan* target = right->findFilterScan(pInfo.right.binding))
+    pushBloomFilter(*left, pInfo.left, target, pInfo.right);
+
+
+  // If the build side is too large, the probe side can be smaller than it
+  // Then materialize the probe side too, and build the smaller one like run()
+  // Otherwise, open the pipeline of the probe side
+
+  if (left->resultSize > PIPELINE_BUILD_MAX)
+  {
+    right->run();
+
+    rightMaterialized = true;
+
+    if (left->resultSize > right->resultSize) 
+    {
+      swap(left, right);
+    
+      swap(pInfo.left, pInfo.right);
+    
+      swap(requestedColumnsLeft, requestedColumnsRight);
+    }
+
+    rightInputColumns = right->getColumns();
+  }
+  else
+  {
+    right->open();
+  }
+
+
+  // Resolve the columns of the build side and the probe side morsels
+
+  unsigned resColId = 0;
+
+  for (auto& info : requestedColumnsLeft) 
+  {
+    copyLeftColumns.push_back(left->getColumn(info));
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  for (auto& info : requestedColumnsRight) 
+  {
+    copyRightColIds.push_back(right->resolve(info));
+  
+    select2ResultColId[info] = resColId++;
+  }
+
+  rightKeyColId = right->resolve(pInfo.right);
+
+
+  // If the build side has no results, the pipeline has nothing to produce
+
+  if (left->resultSize == 0)
+  {
+    buildEmpty = true;
+
+    return;
+  }
+
+
+  // Build phase
+
+  auto leftKey = left->getColumn(pInfo.left);
+
+  std::unique_ptr<uint64_t[]> gatheredKeys;
+
+  buildHashTable(gatherKeys(arena, leftKey, left->resultSize, gatheredKeys), left->resultSize);
+}
+
+// Produce the result of the source tuples [start, end) into the morsel
+void Join::produce(uint64_t start, uint64_t end, Morsel& morsel)
+{
+  // Get the morsel of the probe side
+  // If the probe side is materialized, use its results directly
+
+  if (!morsel.input)
+    morsel.input = std::make_unique<Morsel>();
+
+  Morsel& input = *morsel.input;
+
+  if (rightMaterialized)
+  {
+    input.gather(rightInputColumns, start, end);
+  }
+  else
+  {
+    right->produce(start, end, input);
+  }
+
+
+  // Probe phase
+
+  morsel.clear(copyLeftColumns.size() + copyRightColIds.size());
+
+  auto rightKeyColumn = input.columns[rightKeyColId];
+
+  for (uint64_t i = 0; i < input.size; i++)
+  {
+    hashTable.Probe(rightKeyColumn[i], [this, i, &input, &morsel](uint64_t leftId) 
+                                        { 
+                                          unsigned relColId = 0;
+
+                                          for (auto& col : copyLeftColumns)
+                                            morsel.buffers[relColId++].push_back(col[leftId]);
+
+                                          for (auto colId : copyRightColIds)
+                                            morsel.buffers[relColId++].push_back(input.columns[colId][i]);
+
+                                          morsel.size++;
+                                        });
+  }
+
+  morsel.seal();
+
+  if (Explain::On())
+    profile.producedSize += morsel.size;
+}
+#endif
+
+// Build the hash table with the keys
+void Join::buildHashTable(uint64_t* keys, uint64_t size)
+{
+  // The build phase of the profile
+  // The cpu time is taken in the tasks, this thread runs the other works while it waits them
+
+  WallTimer timer(profile.buildWallNs);
+
+  profile.hashTableSize = size;
+
+#ifdef SINGLE_THREAD_MODE
+  CpuTimer cpuTimer(profile.buildCpuNs);
+
+  hashTable.Reset(0);
+
+  hashTable[0].Build(keys, size);
+#endif
+#ifdef MULTI_THREAD_MODE
+  // If the build side is small, partitioning is not worth it
+
+  if (size < PARTITION_BUILD_MIN)
+  {
+    CpuTimer cpuTimer(profile.buildCpuNs);
+
+    hashTable.Reset(0);
+
+    hashTable[0].Build(keys, size);
+
+    return;
+  }
+
+
+  // Choose the number of partitions, so each partition has about PARTITION_SIZE entries
+
+  unsigned radix_bits = 1;
+
+  while (radix_bits < RADIX_BITS_MAX && (size >> radix_bits) > PARTITION_SIZE)
+    radix_bits++;
+
+  hashTable.Reset(radix_bits);
+
+  uint64_t partition_cnt = hashTable.PartitionCount();
+
+
+  // Divide the keys into chunks, each chunk is partitioned by one task
+
+  uint64_t chunk_cnt = PROBE_COUNT_MAX;
+
+  uint64_t unit = size / chunk_cnt;
+
+  auto chunk_start = [unit](uint64_t chunk) { return chunk * unit; };
+
+  auto chunk_end = [unit, size, chunk_cnt](uint64_t chunk) { return chunk == chunk_cnt - 1 ? size : (chunk + 1) * unit; };
+
+
+  // Count the keys of each partitions in each chunks
+
+  std::vector<std::vector<uint64_t>> offsets(chunk_cnt, std::vector<uint64_t>(partition_cnt, 0));
+
+  auto count = [&](uint64_t chunk)
+                {
+                  CpuTimer cpuTimer(profile.buildCpuNs);
+
+                  std::vector<uint64_t>& histogram = offsets[chunk];
+
+                  for (uint64_t i = chunk_start(chunk), end = chunk_end(chunk); i < end; i++)
+                  {
+                    histogram[PartitionedHashTable::Partition(HashTable::Hash(keys[i]), radix_bits)]++;
+                  }
+                };
+
+  std::vector<std::future<void>> task_list;
+
+  for (uint64_t chunk = 0; chunk < chunk_cnt; chunk++)
+  {
+    task_list.push_back(threadpool.Request(count, chunk));
+  }
+
+  for (auto& task : task_list)
+  {
+    threadpool.RequestWait(std::move(task));
+  }
+
+  task_list.clear();
+
+
+  // Change the counts to the write offsets
+  // Partition by partition, then chunk by chunk. So the entries of one partition are contiguous
+
+  std::vector<uint64_t> partition_start(partition_cnt + 1, 0);
+
+  uint64_t offset = 0;
+
+  for (uint64_t partition = 0; partition < partition_cnt; partition++)
+  {
+    partition_start[partition] = offset;
+
+    for (uint64_t chunk = 0; chunk < chunk_cnt; chunk++)
+    {
+      uint64_t cnt = offsets[chunk][partition];
+
+      offsets[chunk][partition] = offset;
+
+      offset += cnt;
+    }
+  }
+
+  partition_start[partition_cnt] = offset;
+
+
+  // Scatter the entries to their partitions
+
+  std::unique_ptr<HashTable::Entry[]> storage;
+
+  HashTable::Entry* partitioned = arena ? arena->Allocate<HashTable::Entry>(size) : (storage.reset(new HashTable::Entry[size]), storage.get());
+
+  auto scatter = [&](uint64_t chunk)
+                  {
+                    CpuTimer cpuTimer(profile.buildCpuNs);
+
+                    std::vector<uint64_t>& cursor = offsets[chunk];
+
+                    for (uint64_t i = chunk_start(chunk), end = chunk_end(chunk); i < end; i++)
+                    {
+                      uint64_t key = keys[i];
+
+                      partitioned[cursor[PartitionedHashTable::Partition(HashTable::Hash(key), radix_bits)]++] = HashTable::Entry{ key, i };
+                    }
+                  };
+
+  for (uint64_t chunk = 0; chunk < chunk_cnt; chunk++)
+  {
+    task_list.push_back(threadpool.Request(scatter, chunk));
+  }
+
+  for (auto& task : task_list)
+  {
+    threadpool.RequestWait(std::move(task));
+  }
+
+  task_list.clear();
+
+
+  // Build the table of each partitions
+  // One task builds the tables of contiguous partitions
+
+  uint64_t group = partition_cnt > PROBE_COUNT_MAX ? partition_cnt / PROBE_COUNT_MAX : 1;
+
+  auto build = [&](uint64_t first, uint64_t last)
+                {
+                  CpuTimer cpuTimer(profile.buildCpuNs);
+
+                  for (uint64_t partition = first; partition < last; partition++)
+                  {
+                    hashTable[partition].Build(partitioned + partition_start[partition], partition_start[partition + 1] - partition_start[partition], radix_bits);
+                  }
+                };
+
+  for (uint64_t first = 0; first < partition_cnt; first += group)
+  {
+    task_list.push_back(threadpool.Request(build, first, std::min(first + group, partition_cnt)));
+  }
+
+  if (Explain::On())
+    profile.tasks += 2 * chunk_cnt + task_list.size();
+
+  for (auto& task : task_list)
+  {
+    threadpool.RequestWait(std::move(task));
+  }
+#endif
+}
+
+#ifdef INDEX_JOIN_MODE
+// Require a column and add it to results
+bool IndexJoin::require(SelectInfo info)
+{
+  // The columns of the relation are read with the row ids of the matches
+  // The other columns are pushed down to the left input
+
+  bool isRight = info.binding == rightKey.binding;
+
+  if (isRight)
+    assert(info.colId < relation.columns.size());
+  else if (!left->require(info))
+    return false;
+
+#ifdef MULTI_THREAD_MODE
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+
+  if (requestedColumns.count(info) == 0)
+  {
+    (isRight ? requestedColumnsRight : requestedColumnsLeft).emplace_back(info);
+
+    tmpResults.emplace_back();
+
+    requestedColumns.emplace(info);
+  }
+
+  return true;
+}
+
+// Run
+void IndexJoin::run()
+{
+  WallTimer timer(profile.wallNs);
+
+  profile.hashTableSize = relation.size;
+
+  // Pushdown the key, then execute the left input
+
+  left->require(leftKey);
+
+  left->run();
+
+
+  // Resolve the input columns
+
+  unsigned resColId = 0;
+
+#ifdef LATE_MATERIALIZATION_MODE
+  // Copy the row ids of the left bindings, and the row ids of the matches in the relation
+
+  std::unordered_map<unsigned, unsigned> binding2RowIdColId;
+
+  std::vector<uint64_t*> copyLeftRowIds;
+
+  std::vector<unsigned> resultRowIdColIds;
+
+  for (auto& info : requestedColumnsLeft) 
+  {
+    ColumnRef ref = left->getColumn(info);
+
+    if (!binding2RowIdColId.count(info.binding))
+    {
+      binding2RowIdColId[info.binding] = copyLeftRowIds.size();
+
+      copyLeftRowIds.push_back(ref.rowIds);
+    }
+
+    resultRefs.push_back(ColumnRef{ ref.base, nullptr });
+
+    resultRowIdColIds.push_back(binding2RowIdColId[info.binding]);
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  for (auto& info : requestedColumnsRight) 
+  {
+    resultRefs.push_back(ColumnRef{ relation.columns[info.colId], nullptr });
+
+    resultRowIdColIds.push_back(copyLeftRowIds.size());
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  bool copyRightRowId = !requestedColumnsRight.empty();
+#else
+  std::vector<uint64_t*> copyLeftData, copyRightData;
+
+  for (auto& info : requestedColumnsLeft) 
+  {
+    copyLeftData.push_back(left->getColumn(info).base);
+
+    select2ResultColId[info] = resColId++;
+  }
+
+  for (auto& info : requestedColumnsRight) 
+  {
+    copyRightData.push_back(relation.columns[info.colId]);
+  
+    select2ResultColId[info] = resColId++;
+  }
+#endif
+
+
+  // If the checksum is fused, the sums of the required columns are the results
+
+  if (checksumFused)
+    resultSums.assign(resColId, 0);
+
+
+  // If the left input has no results, the join has no results
+
+  if (left->resultSize == 0)
+  {
+    resultSize = 0;
+
+#ifndef LATE_MATERIALIZATION_MODE
+    referResults();
+#endif
+
+    return;
+  }
+
+  auto leftKeyColumn = left->getColumn(leftKey);
+
+
+  // Probe phase with the fused checksum
+  // Sum the required columns of the matches, the result is not materialized
+
+  if (checksumFused)
+  {
+    std::vector<ColumnRef> sumLeftColumns;
+
+    std::vector<uint64_t*> sumRightColumns;
+
+    for (auto& info : requestedColumnsLeft)
+      sumLeftColumns.push_back(left->getColumn(info));
+
+    for (auto& info : requestedColumnsRight)
+      sumRightColumns.push_back(relation.columns[info.colId]);
+
+    auto probe = [this, &leftKeyColumn, &sumLeftColumns, &sumRightColumns](uint64_t start, uint64_t end, std::vector<uint64_t>& sums)
+                 {
+                   uint64_t matched = 0;
+
+                   for (uint64_t i = start; i < end; i++)
+                   {
+                     uint64_t count = 0;
+
+                     index.Probe(leftKeyColumn[i], [&sums, &sumLeftColumns, &sumRightColumns, &count](uint64_t rowId)
+                                                   {
+                                                     for (unsigned cId = 0; cId < sumRightColumns.size(); cId++)
+                                                       sums[sumLeftColumns.size() + cId] += sumRightColumns[cId][rowId];
+
+                                                     count++;
+                                                   });
+
+                     // The left tuple is in the result once for each match
+
+                     if (count == 0)
+                       continue;
+
+                     for (unsigned cId = 0; cId < sumLeftColumns.size(); cId++)
+                       sums[cId] += count * sumLeftColumns[cId][i];
+
+                     matched += count;
+                   }
+
+                   return matched;
+                 };
+
+#ifdef SINGLE_THREAD_MODE
+    resultSize = probe(0, left->resultSize, resultSums);
+#endif
+#ifdef MULTI_THREAD_MODE
+    resultSize = sumMorsels(left->resultSize, indexJoinTupleCost, profile, resultSums, probe);
+#endif
+
+    return;
+  }
+
+
+  // Probe phase
+
+#ifdef SINGLE_THREAD_MODE
+  for (uint64_t i = 0; i < left->resultSize; i++)
+  {
+    index.Probe(leftKeyColumn[i], [this, i, &copyLeftData, &copyRightData](uint64_t rowId)
+                                  {
+                                    unsigned relColId = 0;
+
+                                    for (auto col : copyLeftData)
+                                      tmpResults[relColId++].push_back(col[i]);
+
+                                    for (auto col : copyRightData)
+                                      tmpResults[relColId++].push_back(col[rowId]);
+
+                                    ++resultSize;
+                                  });
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+
+  // The columns to materialize
+  // In late materialization mode, they are the row id columns of the bindings
+
+#ifdef LATE_MATERIALIZATION_MODE
+  rowIdResults.assign(copyLeftRowIds.size() + copyRightRowId, nullptr);
+
+  std::vector<uint64_t*>& results = rowIdResults;
+#else
+  std::vector<uint64_t*>& results = tmpResults;
+#endif
+
+  // Probe the index morsel by morsel
+
+  resultSize = materializeMorsels(arena, left->resultSize, indexJoinTupleCost, profile, results, 
+                                  [&](uint64_t start, uint64_t end, TmpResult& tmpResult)
+                                  {
+                                    uint64_t matched = 0;
+
+                                    for (uint64_t i = start; i < end; i++)
+                                    {
+                                      index.Probe(leftKeyColumn[i], [&, i](uint64_t rowId)
+                                                                    {
+                                                                      unsigned relColId = 0;
+#ifdef LATE_MATERIALIZATION_MODE
+                                                                      for (auto rowIds : copyLeftRowIds)
+                                                                        tmpResult[relColId++].push_back(rowIds ? rowIds[i] : i);
+
+                                                                      if (copyRightRowId)
+                                                                        tmpResult[relColId].push_back(rowId);
+#else
+                                                                      for (auto col : copyLeftData)
+                                                                        tmpResult[relColId++].push_back(col[i]);
+
+                                                                      for (auto col : copyRightData)
+                                                                        tmpResult[relColId++].push_back(col[rowId]);
+#endif
+                                                                      matched++;
+                                                                    });
+                                    }
+
+                                    return matched;
+                                  });
+#endif
+
+
+  // Refer the results
+
+#ifdef LATE_MATERIALIZATION_MODE
+  for (unsigned cId = 0; cId < resultRefs.size(); cId++)
+    resultRefs[cId].rowIds = rowIdResults[resultRowIdColIds[cId]];
+#else
+  referResults();
+#endif
+}
+#endif
+
+#ifdef SINGLE_THREAD_MODE
+// Copy to result
+void SelfJoin::copy2Result(uint64_t id)
+{
+  for (unsigned cId = 0; cId < copyData.size(); cId++)
+    tmpResults[cId].push_back(copyData[cId][id]);
+
+  ++resultSize;
+}
+#endif
+#ifdef MULTI_THREAD_MODE
+// Copy to result
+inline void SelfJoin::copy2Result(uint64_t id, TmpResult& tmpResult)
+{
+  for (unsigned cId = 0; cId < copyData.size(); cId++)
+    tmpResult[cId].push_back(copyData[cId][id]);
+}
+#endif
+#ifdef LATE_MATERIALIZATION_MODE
+// Copy row ids of tuple to result
+inline void SelfJoin::copyRowIds2Result(uint64_t id, TmpResult& tmpResult)
+{
+  unsigned cId = 0;
+
+  for (auto rowIds : copyRowIds)
+    tmpResult[cId++].push_back(rowIds ? rowIds[id] : id);
+}
+#endif
+
+// Require a column and add it to results
+bool SelfJoin::require(SelectInfo info)
+{
+
+  if (requiredIUs.count(info))
+  {
+      return true;
+  }
+
+
+  if(input->require(info)) 
+  {
+#ifdef MULTI_THREAD_MODE
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+
+    tmpResults.emplace_back();
+    
+    requiredIUs.emplace(info);
+
+    return true;
+  }
+    
+  return false;
+}
+
+// Run
+void SelfJoin::run()
+{
+  WallTimer timer(profile.wallNs);
+
+  // Projection pushdown
+
+  input->require(pInfo.left);
+
+  input->require(pInfo.right); 
+  
+
+  // Run the operators below
+
+  input->run();
+
+
+  // Get the column's starting address
+  // In late materialization mode, get the row ids of each bindings instead
+
+  unsigned resColId = 0;
+
+#ifdef LATE_MATERIALIZATION_MODE
+  std::unordered_map<unsigned, unsigned> binding2RowIdColId;
+
+  std::vector<unsigned> resultRowIdColIds;
+#endif
+
+  for (auto& iu : requiredIUs) 
+  {
+    ColumnRef ref = input->getColumn(iu);
+
+#ifdef LATE_MATERIALIZATION_MODE
+    if (!binding2RowIdColId.count(iu.binding))
+    {
+      binding2RowIdColId[iu.binding] = copyRowIds.size();
+
+      copyRowIds.push_back(ref.rowIds);
+    }
+
+    resultRefs.push_back(ColumnRef{ ref.base, nullptr });
+
+    resultRowIdColIds.push_back(binding2RowIdColId[iu.binding]);
+#else
+    copyData.emplace_back(ref.base);
+#endif
+
+    select2ResultColId.emplace(iu, resColId++);
+  }
+
+
+  // Access to the columns
+
+  auto leftCol = input->getColumn(pInfo.left);
+
+  auto rightCol = input->getColumn(pInfo.right);
+
+
+  // If the checksum is fused, sum the required columns of the passed tuples instead of materializing them
+
+  if (checksumFused)
+  {
+    std::vector<ColumnRef> sumColumns;
+
+    for (auto& iu : requiredIUs)
+      sumColumns.push_back(input->getColumn(iu));
+
+    resultSums.assign(sumColumns.size(), 0);
+
+    auto probe = [&leftCol, &rightCol, &sumColumns](uint64_t start, uint64_t end, std::vector<uint64_t>& sums)
+                 {
+                   uint64_t passed = 0;
+
+                   for (uint64_t i = start; i < end; i++)
+                   {
+                     if (leftCol[i] != rightCol[i])
+                       continue;
+
+                     for (unsigned cId = 0; cId < sumColumns.size(); cId++)
+                       sums[cId] += sumColumns[cId][i];
+
+                     passed++;
+                   }
+
+                   return passed;
+                 };
+
+#ifdef SINGLE_THREAD_MODE
+    resultSize = probe(0, input->resultSize, resultSums);
+#endif
+#ifdef MULTI_THREAD_MODE
+    resultSize = sumMorsels(input->resultSize, selfJoinTupleCost, profile, resultSums, probe);
+#endif
+
+    return;
+  }
+
+
+  // Compare left key is same with right key
+#ifdef SINGLE_THREAD_MODE
+  for (uint64_t i = 0; i < input->resultSize; i++) 
+  {
+    if (leftCol[i] == rightCol[i])
+      copy2Result(i);
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+
+  // The columns to materialize
+  // In late materialization mode, they are the row id columns of the bindings
+
+#ifdef LATE_MATERIALIZATION_MODE
+  rowIdResults.assign(copyRowIds.size(), nullptr);
+
+  std::vector<uint64_t*>& results = rowIdResults;
+#else
+  std::vector<uint64_t*>& results = tmpResults;
+#endif
+
+  // Compare the columns morsel by morsel
+
+  uint64_t size = materializeMorsels(arena, input->resultSize, selfJoinTupleCost, profile, results, 
+                                     [this, &leftCol, &rightCol](uint64_t start, uint64_t end, TmpResult& tmpResult)
+                                     {
+                                       uint64_t passed = 0;
+
+                                       for (uint64_t i = start; i < end; i++) 
+                                       {
+                                         if (leftCol[i] != rightCol[i])
+                                           continue;
+#ifdef LATE_MATERIALIZATION_MODE
+                                         copyRowIds2Result(i, tmpResult);
+#else
+                                         copy2Result(i, tmpResult);
+#endif
+                                         passed++;
+                                       }
+
+                                       return passed;
+                                     });
+
+
+  resultSize = size;
+
+#endif
+
+
+  // Refer the results
+
+#ifdef LATE_MATERIALIZATION_MODE
+  for (unsigned cId = 0; cId < resultRefs.size(); cId++)
+    resultRefs[cId].rowIds = rowIdResults[resultRowIdColIds[cId]];
+#else
+  referResults();
+#endif
+}
+
+#ifdef PIPELINE_MODE
+// Prepare the streaming, open the input
+void SelfJoin::open()
+{
+  WallTimer timer(profile.wallNs);
+
+  // Projection pushdown
+
+  input->require(pInfo.left);
+
+  input->require(pInfo.right);
+
+  input->open();
+
+
+  // Resolve the columns of the input morsel
+
+  for (auto& iu : requiredIUs) 
+  {
+    copyColIds.push_back(input->resolve(iu));
+
+    select2ResultColId.emplace(iu, copyColIds.size() - 1);
+  }
+
+  leftColId = input->resolve(pInfo.left);
+
+  rightColId = input->resolve(pInfo.right);
+}
+
+// Produce the result of the source tuples [start, end) into the morsel
+void SelfJoin::produce(uint64_t start, uint64_t end, Morsel& morsel)
+{
+  if (!morsel.input)
+    morsel.input = std::make_unique<Morsel>();
+
+  Morsel& inputMorsel = *morsel.input;
+
+  input->produce(start, end, inputMorsel);
+
+
+  // Compare left key is same with right key
+
+  morsel.clear(copyColIds.size());
+
+  auto leftCol = inputMorsel.columns[leftColId];
+
+  auto rightCol = inputMorsel.columns[rightColId];
+
+  for (uint64_t i = 0; i < inputMorsel.size; i++)
+  {
+    if (leftCol[i] != rightCol[i])
+      continue;
+
+    for (unsigned cId = 0; cId < copyColIds.size(); cId++)
+      morsel.buffers[cId].push_back(inputMorsel.columns[copyColIds[cId]][i]);
+
+    morsel.size++;
+  }
+
+  morsel.seal();
+
+  if (Explain::On())
+    profile.producedSize += morsel.size;
+}
+#endif
+
+// Run
+void Checksum::run()
+{
+  WallTimer timer(profile.wallNs);
+
+  // Projection pushdown
+  // About the list of columns that are needed to compute the final check sum,
+  // Require to include these columns in the result of the operation
+
+  for (auto& sInfo : colInfo) 
+  {
+    input->require(sInfo);
+  }
+
+
+  // If the input can be streamed, sum the morsels without materialization
+
+#ifdef PIPELINE_MODE
+  if (input->streamable())
+  {
+    runPipeline();
+
+    return;
+  }
+#endif
+
+
+  // Start operation
+
+  input->run();
+
+
+  // If the checksum is fused into the input, the input has summed the columns already
+
+  if (input->checksumFused)
+  {
+    resultSize = input->resultSize;
+
+    for (auto& sInfo : colInfo) 
+      checkSums.push_back(input->resultSums[input->resolve(sInfo)]);
+
+    return;
+  }
+
+
+  // Get the sum of each required columns
+  // All the columns are summed in one pass over the tuples, morsel by morsel in parallel
+
+  std::vector<ColumnRef> resultCols;
+
+  for (auto& sInfo : colInfo) 
+    resultCols.push_back(input->getColumn(sInfo));
+
+  resultSize = input->resultSize;
+
+  checkSums.assign(resultCols.size(), 0);
+
+  if (resultCols.empty())
+    return;
+
+#ifdef SINGLE_THREAD_MODE
+  sumColumns(resultCols, 0, resultSize, checkSums.data());
+#endif
+#ifdef MULTI_THREAD_MODE
+  sumMorsels(resultSize, checksumTupleCost, profile, checkSums, 
+             [&resultCols](uint64_t start, uint64_t end, std::vector<uint64_t>& sums)
+             {
+               sumColumns(resultCols, start, end, sums.data());
+
+               return end - start;
+             });
+#endif
+}
+
+#ifdef PIPELINE_MODE
+// Sum the columns while the morsels flow from the input
+void Checksum::runPipeline()
+{
+  // Run the pipeline breakers
+
+  input->open();
+
+  std::vector<unsigned> colIds;
+
+  for (auto& sInfo : colInfo) 
+  {
+    colIds.push_back(input->resolve(sInfo));
+  }
+
+
+  // Workers claim the morsels of the source with the cursors of the nodes
+  // Each worker has its own partial sums
+  // The morsels of the pipeline are the probe of the profile
+
+  WallTimer probeTimer(profile.probeWallNs);
+
+  uint64_t size = input->sourceSize();
+
+  uint64_t morsel_cnt = (size + MORSEL_SIZE - 1) / MORSEL_SIZE;
+
+  if (Explain::On())
+    profile.tasks += morsel_cnt;
+
+  uint64_t worker_cnt = std::min<uint64_t>(threadpool.Size() + 1, std::max<uint64_t>(morsel_cnt, 1)); // This thread works too
+
+  NodeCursors cursors(morsel_cnt);
+
+  std::vector<std::vector<uint64_t>> partial_sums(worker_cnt, std::vector<uint64_t>(colIds.size(), 0));
+
+  std::vector<uint64_t> partial_sizes(worker_cnt, 0);
+
+  auto pipeline = [&](uint64_t worker)
+                  {
+                    CpuTimer cpuTimer(profile.probeCpuNs);
+
+                    Morsel morsel;
+
+                    std::vector<uint64_t>& sums = partial_sums[worker];
+
+                    uint64_t index;
+
+                    while (cursors.Next(index))
+                    {
+                      uint64_t start = index * MORSEL_SIZE;
+
+                      input->produce(start, std::min(start + MORSEL_SIZE, size), morsel);
+
+                      for (unsigned i = 0; i < colIds.size(); i++)
+                        sums[i] += Reduction::Sum(morsel.columns[colIds[i]], nullptr, morsel.size);
+
+                      partial_sizes[worker] += morsel.size;
+                    }
+                  };
+
+  std::vector<std::future<void>> pipeline_list;
+
+  for (uint64_t worker = 1; worker < worker_cnt; worker++)
+  {
+    pipeline_list.push_back(threadpool.Request(pipeline, worker));
+  }
+
+  pipeline(0);
+
+  for (auto& task : pipeline_list)
+  {
+    threadpool.RequestWait(std::move(task));
+  }
+
+
+  // Merge the partial sums
+
+  checkSums.assign(colIds.size(), 0);
+
+  resultSize = 0;
+
+  for (uint64_t worker = 0; worker < worker_cnt; worker++)
+  {
+    for (unsigned i = 0; i < colIds.size(); i++)
+      checkSums[i] += partial_sums[worker][i];
+
+    resultSize += partial_sizes[worker];
+  }
+}
+#endif
@@ -0,0 +1,353 @@
+#include <cassert>
+#include <charconv>
+#include <iostream>
+#include <utility>
+#include <sstream>
+
+#include "Parser.hpp"
+
+
+using namespace std;
+
+
+// The parser reads the text in one pass without copying it
+// The tokens are the views of the text, and the numbers are converted from the views directly
+
+// Take the token before the delimiter, then move the text after the delimiter
+static string_view nextToken(string_view& text, const char delimiter)
+{
+  size_t end = text.find(delimiter);
+
+  string_view token = text.substr(0, end);
+
+  text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+
+  return token;
+}
+
+// Convert the token to a number
+template <typename T>
+static T parseNumber(string_view token)
+{
+  T value = 0;
+
+  auto result = from_chars(token.data(), token.data() + token.size(), value);
+
+  assert(result.ec == errc() && result.ptr == token.data() + token.size() && "a token is always a number");
+
+  return value;
+}
+
+// Parse a string of relation ids
+void QueryInfo::parseRelationIds(string_view rawRelations)
+{
+  while (!rawRelations.empty())
+  {
+    auto token = nextToken(rawRelations, ' ');
+
+    if (!token.empty())
+      relationIds.push_back(parseNumber<RelationId>(token));
+  }
+}
+
+// Parse the string to the SelectInfo
+// ex) r1.col2 => SelectInfo(0, 1, 2)
+static SelectInfo parseRelColPair(string_view raw)
+{
+  auto binding = nextToken(raw, '.'); // raw : col id
+
+  // SelectInfo(relId, binding, colId)
+  // [Predicates] and [Projections] has no information about their real relation id
+  // Becuase their relId is the index of [Relations]. If [Relations] is 0 2 4, relId of "1.x" means index of relId in [Relations], real relId = 2
+  // So store the binding id and real relId will be stored using relationIds at resolveIds()
+
+  return SelectInfo(0, parseNumber<unsigned>(binding), parseNumber<unsigned>(raw));
+}
+
+// If this string has no '.', it means this string is constant
+inline static bool isConstant(string_view raw) { return raw.find('.') == string_view::npos; }
+
+// Parse a single predicate: join "r1Id.col1Id=r2Id.col2Id" or "r1Id.col1Id=constant" filter
+void QueryInfo::parsePredicate(string_view rawPredicate)
+{
+  // Split left and right at the comparison
+
+  size_t comparison = rawPredicate.find_first_of("<>=");
+
+  assert(comparison != string_view::npos);
+
+  string_view left = rawPredicate.substr(0, comparison), right = rawPredicate.substr(comparison + 1);
+  
+  assert(!isConstant(left) && "left side of a predicate is always a SelectInfo");
+  
+  
+  // Make "rid.colid" to SelectInfo
+  
+  auto leftSelect = parseRelColPair(left);
+
+
+  // Check whether this predicate is filetering or joining
+  
+  if (isConstant(right)) // Filter
+  {
+    filters.emplace_back(leftSelect, parseNumber<uint64_t>(right), FilterInfo::Comparison(rawPredicate[comparison]));
+  } 
+  else // Join
+  {
+    predicates.emplace_back(leftSelect, parseRelColPair(right));
+  }
+}
+
+// Parse predicates
+void QueryInfo::parsePredicates(string_view text)
+{
+  // Parse each predicates
+  // ex) 0.1=1.2&1.0=2.1&0.1>3000 => 0.1=1.2 / 1.0=2.1 / 0.1>3000
+  // It will be pushed to the filters or predicates
+
+  while (!text.empty())
+  {
+    parsePredicate(nextToken(text, '&'));
+  }
+}
+
+// Parse selections
+void QueryInfo::parseSelections(string_view rawSelections)
+{
+  // Split string like "0.0 1.1"
+
+  while (!rawSelections.empty())
+  {
+    auto token = nextToken(rawSelections, ' ');
+
+    if (!token.empty())
+      selections.emplace_back(parseRelColPair(token));
+  }
+}
+
+// Resolve relation id
+static void resolveIds(vector<unsigned>& relationIds, SelectInfo& selectInfo)
+{
+  selectInfo.relId = relationIds[selectInfo.binding];
+}
+
+// Resolve relation ids
+void QueryInfo::resolveRelationIds()
+{
+  // Selections
+
+  for (auto& sInfo : selections) 
+  {
+    resolveIds(relationIds, sInfo);
+  }
+
+
+  // Predicates
+
+  for (auto& pInfo : predicates) 
+  {
+    resolveIds(relationIds, pInfo.left);
+
+    resolveIds(relationIds, pInfo.right);
+  }
+
+
+  // Filters
+
+  for (auto& fInfo : filters) 
+  {
+    resolveIds(relationIds,fInfo.filterColumn);
+  }
+}
+
+// Parse query [RELATIONS]|[PREDICATES]|[SELECTS]
+void QueryInfo::parseQuery(string_view rawQuery)
+{
+  // Reset remaining query info
+  // The vectors keep their capacity, so a reused query info does not allocate again
+
+  clear();
+
+
+  // Split raw query [RELATIONS], [PREDICATES], [SELECTS]
+
+  auto rawRelations = nextToken(rawQuery, '|');
+
+  auto rawPredicates = nextToken(rawQuery, '|');
+
+  auto rawSelections = nextToken(rawQuery, '|');
+  
+  assert(rawQuery.empty());
+  
+  
+  // Parse them
+
+  parseRelationIds(rawRelations);  // [RELATIONS]  ex) "0 2 4", push relation ids to the this->relationId (member vector)
+  
+  parsePredicates(rawPredicates);   // [PREDICATES] ex) "0.1=1.2&1.0=2.1&0.1>3000", push predicates to the this->predicates (member vector)
+  
+  parseSelections(rawSelections);   // [SELECTS]    ex) "0.0 1.1", push selections to the this->selections (member vector)
+
+  
+  // At now, all SelectIds has no real relId, just index about this->relationId (binding)
+  // Set real relId
+
+  resolveRelationIds();
+}
+
+// Reset query info
+void QueryInfo::clear()
+{
+  relationIds.clear();
+
+  predicates.clear();
+  
+  filters.clear();
+  
+  selections.clear();
+}
+
+// Wraps relation id into quotes to be a SQL compliant string
+static string wrapRelationName(uint64_t id)
+{
+  return "\"" + to_string(id) + "\"";
+}
+
+// Appends a selection info to the stream
+string SelectInfo::dumpSQL(bool addSUM)
+{
+  auto innerPart = wrapRelationName(binding) + ".c" + to_string(colId);
+
+  return addSUM ? "SUM(" + innerPart + ")" : innerPart;
+}
+
+// Dump text format
+string SelectInfo::dumpText()
+{
+  return to_string(binding) + "." + to_string(colId);
+}
+
+// Dump text format
+string FilterInfo::dumpText()
+{
+  return filterColumn.dumpText() + static_cast<char>(comparison) + to_string(constant);
+}
+
+// Dump text format
+string FilterInfo::dumpSQL()
+{
+  return filterColumn.dumpSQL() + static_cast<char>(comparison) + to_string(constant);
+}
+
+// Dump text format
+string PredicateInfo::dumpText()
+{
+  return left.dumpText() + '=' + right.dumpText();
+}
+
+// Dump text format
+string PredicateInfo::dumpSQL()
+{
+  return left.dumpSQL() + '=' + right.dumpSQL();
+}
+
+template <typename T>
+static void dumpPart(stringstream& ss,vector<T> elements)
+{
+  for (unsigned i = 0; i < elements.size(); i++) 
+  {
+    ss << elements[i].dumpText();
+    
+    if (i < elements.size() - 1)
+      ss << T::delimiter;
+  }
+}
+
+template <typename T>
+static void dumpPartSQL(stringstream& ss, vector<T> elements)
+{
+  for (unsigned i = 0; i < elements.size(); i++) 
+  {
+    ss << elements[i].dumpSQL();
+    
+    if (i < elements.size() - 1)
+      ss << T::delimiterSQL;
+  }
+}
+
+// Dump text format
+string QueryInfo::dumpText()
+{
+  stringstream text;
+
+
+  // Relations
+
+  for (unsigned i = 0; i < relationIds.size(); i++) 
+  {
+    text << relationIds[i];
+  
+    if (i < relationIds.size() - 1)
+      text << " ";
+  }
+
+  text << "|";
+
+
+  dumpPart(text,predicates);
+
+  if (predicates.size() && filters.size())
+    text << PredicateInfo::delimiter;
+
+  dumpPart(text,filters);
+  
+  text << "|";
+  
+  dumpPart(text,selections);
+
+  return text.str();
+}
+
+// Dump SQL
+string QueryInfo::dumpSQL()
+{
+  stringstream sql;
+
+  sql << "SELECT ";
+
+  for (unsigned i = 0; i < selections.size(); i++) 
+  {
+    sql << selections[i].dumpSQL(true);
+  
+    if (i < selections.size() - 1)
+      sql << ", ";
+  }
+
+
+  sql << " FROM ";
+
+  for (unsigned i = 0; i < relationIds.size(); i++) 
+  {
+    sql << "r" << relationIds[i] << " " << wrapRelationName(i);
+  
+    if (i < relationIds.size() - 1)
+      sql << ", ";
+  }
+
+
+  sql << " WHERE ";
+
+  dumpPartSQL(sql,predicates);
+
+  if (predicates.size() && filters.size())
+    sql << " and ";
+
+  dumpPartSQL(sql,filters);
+
+  sql << ";";
+
+
+  return sql.str();
+}
+
+QueryInfo::QueryInfo(string_view rawQuery) { parseQuery(rawQuery); }
\ No newline at end of file
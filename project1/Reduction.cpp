@@ -0,0 +1,136 @@
+#include "Reduction.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+// Sum with the scalar loop
+static uint64_t sumScalar(const uint64_t* col, const uint64_t* rowIds, uint32_t count)
+{
+  uint64_t sum = 0;
+
+  if (rowIds)
+  {
+    for (uint32_t i = 0; i < count; i++)
+      sum += col[rowIds[i]];
+  }
+  else
+  {
+    for (uint32_t i = 0; i < count; i++)
+      sum += col[i];
+  }
+
+  return sum;
+}
+
+// Sum the tail that is left by the vectorized loop
+static inline uint64_t sumTail(const uint64_t* col, const uint64_t* rowIds, uint32_t i, uint32_t count)
+{
+  return rowIds ? sumScalar(col, rowIds + i, count - i) : sumScalar(col + i, nullptr, count - i);
+}
+
+#if defined(__x86_64__)
+// Sum with AVX2, 8 values at once in two accumulators
+// The values of the row ids are gathered 4 at once
+__attribute__((target("avx2")))
+static uint64_t sumAVX2(const uint64_t* col, const uint64_t* rowIds, uint32_t count)
+{
+  __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+
+  auto base = reinterpret_cast<const long long*>(col);
+
+  uint32_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i values0, values1;
+
+    if (rowIds)
+    {
+      values0 = _mm256_i64gather_epi64(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowIds + i)), 8);
+
+      values1 = _mm256_i64gather_epi64(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rowIds + i + 4)), 8);
+    }
+    else
+    {
+      values0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+
+      values1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i + 4));
+    }
+
+    sum0 = _mm256_add_epi64(sum0, values0);
+
+    sum1 = _mm256_add_epi64(sum1, values1);
+  }
+
+
+  // Merge the lanes, then add the tail
+
+  alignas(32) uint64_t lanes[4];
+
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(sum0, sum1));
+
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumTail(col, rowIds, i, count);
+}
+
+// Sum with AVX-512, 16 values at once in two accumulators
+// The values of the row ids are gathered 8 at once
+__attribute__((target("avx512f")))
+static uint64_t sumAVX512(const uint64_t* col, const uint64_t* rowIds, uint32_t count)
+{
+  __m512i sum0 = _mm512_setzero_si512(), sum1 = _mm512_setzero_si512();
+
+  uint32_t i = 0;
+
+  for (; i + 16 <= count; i += 16)
+  {
+    __m512i values0, values1;
+
+    if (rowIds)
+    {
+      values0 = _mm512_i64gather_epi64(_mm512_loadu_si512(rowIds + i), col, 8);
+
+      values1 = _mm512_i64gather_epi64(_mm512_loadu_si512(rowIds + i + 8), col, 8);
+    }
+    else
+    {
+      values0 = _mm512_loadu_si512(col + i);
+
+      values1 = _mm512_loadu_si512(col + i + 8);
+    }
+
+    sum0 = _mm512_add_epi64(sum0, values0);
+
+    sum1 = _mm512_add_epi64(sum1, values1);
+  }
+
+  return _mm512_reduce_add_epi64(_mm512_add_epi64(sum0, sum1)) + sumTail(col, rowIds, i, count);
+}
+#endif
+
+using SumFunction = uint64_t (*)(const uint64_t*, const uint64_t*, uint32_t);
+
+// Choose the widest kernel that the cpu supports
+static SumFunction chooseKernel()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return sumAVX512;
+
+  if (__builtin_cpu_supports("avx2"))
+    return sumAVX2;
+#endif
+
+  return sumScalar;
+}
+
+// The sum of col[0, count), or of col[rowIds[0, count)] if the row ids are given
+uint64_t Reduction::Sum(const uint64_t* col, const uint64_t* rowIds, uint32_t count)
+{
+  static const SumFunction sum = chooseKernel();
+
+  return sum(col, rowIds, count);
+}
@@ -0,0 +1,685 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Executeoptions.hpp"
+#include "Relation.hpp"
+#include "Threadpool.hpp"
+
+
+extern ThreadPool threadpool;
+
+
+using namespace std;
+
+
+constexpr uint64_t HISTOGRAM_CHUNK_SIZE = 1 << 20;  // Tuples of a column that one work summarizes and counts
+
+constexpr uint64_t ZONE_MAP_CHUNK_SIZE = 1 << 20;   // Tuples of a column that one work makes the zones of
+
+static_assert(ZONE_MAP_CHUNK_SIZE % ZONE_SIZE == 0, "A chunk has whole zones");
+
+constexpr uint64_t COPY_CHUNK_SIZE = 1 << 20;      // Tuples of the columns that one work copies to the placed memory
+
+constexpr uint32_t STATISTICS_VERSION = 1;          // Increase it when the format of the statistics file is changed
+
+constexpr uint32_t STATISTICS_EQUI_DEPTH = 1;       // The flag of the statistics file that has the equi-depth histograms
+
+
+// The header of the statistics file
+// The statistics are valid only for the relation file of the same size and modification time
+struct StatisticsHeader
+{
+  char magic[8];
+
+  uint32_t version;
+
+  uint32_t flags;
+
+  uint64_t fileSize;
+
+  int64_t mtimeSec;
+
+  int64_t mtimeNsec;
+
+  uint64_t size;
+
+  uint64_t columnCnt;
+};
+
+// The statistics file of the relation file
+static string statisticsFileName(const string& fileName)
+{
+  return fileName + ".stats";
+}
+
+// Make the header for the current relation file, false if the relation file can not be found
+static bool makeStatisticsHeader(const string& fileName, uint64_t size, uint64_t columnCnt, StatisticsHeader& header)
+{
+  struct stat sb;
+
+  if (fileName.empty() || stat(fileName.c_str(), &sb) == -1)
+    return false;
+
+  memset(&header, 0, sizeof(header));
+
+  memcpy(header.magic, "SIGSTATS", sizeof(header.magic));
+
+  header.version = STATISTICS_VERSION;
+
+#ifdef EQUI_DEPTH_HISTOGRAM_MODE
+  header.flags = STATISTICS_EQUI_DEPTH;
+#endif
+
+  header.fileSize = sb.st_size;
+
+  header.mtimeSec = sb.st_mtim.tv_sec;
+
+  header.mtimeNsec = sb.st_mtim.tv_nsec;
+
+  header.size = size;
+
+  header.columnCnt = columnCnt;
+
+  return true;
+}
+
+
+// Stores a relation into a binary file
+void Relation::storeRelation(const string& fileName)
+{
+  ofstream outFile;
+
+  outFile.open(fileName, ios::out | ios::binary);
+  
+
+  // Header
+
+  outFile.write((char*)&size, sizeof(size));
+  
+  auto numColumns = columns.size();
+  
+  outFile.write((char*)&numColumns, sizeof(size_t));
+  
+
+  // Data
+
+  for (auto c : columns) 
+  {
+    outFile.write((char*)c, size * sizeof(uint64_t));
+  }
+  
+
+  outFile.close();
+}
+
+
+// Stores a relation into a file (csv), e.g., for loading/testing it with a DBMS
+void Relation::storeRelationCSV(const string& fileName)
+{
+  ofstream outFile;
+
+  outFile.open(fileName+".tbl",ios::out);
+  
+  
+  for (uint64_t i = 0; i < size; i++) 
+  {
+    for (auto& c : columns) 
+    {
+      outFile << c[i] << '|';
+    }
+
+    outFile << "\n";
+  }
+}
+
+
+// Dump SQL: Create and load table (PostgreSQL)
+void Relation::dumpSQL(const string& fileName, unsigned relationId)
+{
+  ofstream outFile;
+
+  outFile.open(fileName + ".sql", ios::out);
+  
+  
+  // Create table statement
+  
+  outFile << "CREATE TABLE r" << relationId << " (";
+  
+  for (unsigned cId = 0; cId < columns.size(); cId++) 
+  {
+    outFile << "c" << cId << " bigint" << (cId < columns.size() -1 ? "," : "");
+  }
+  
+  outFile << ");\n";
+
+
+  // Load from csv statement
+  
+  outFile << "copy r" << relationId << " from 'r" << relationId << ".tbl' delimiter '|';\n";
+}
+
+
+void Relation::loadRelation(const char* fileName)
+{
+  int fd = open(fileName, O_RDONLY);
+
+  if (fd == -1) 
+  {
+    cerr << "cannot open " << fileName << endl;
+    
+    throw;
+  }
+
+
+  // Obtain file size
+  
+  struct stat sb;
+  
+  if (fstat(fd, &sb) == -1)
+    cerr << "fstat\n";
+
+  auto length = sb.st_size;
+
+
+  // The columns are copied when they are placed on huge pages or on the NUMA nodes
+  // Otherwise the file mapping is read by the queries
+
+  bool copyColumns = false;
+
+#ifdef HUGE_PAGE_MODE
+  copyColumns = true;
+#endif
+
+#ifdef NUMA_MODE
+  copyColumns = copyColumns || Numa::NodeCount() > 1;
+#endif
+
+
+  // Map the file to the memory
+  // The mapping read by the queries is populated now, so the first query that touches a column does not pay the page faults
+
+  int flags = MAP_PRIVATE;
+
+#ifdef PREFAULT_MODE
+  if (!copyColumns)
+    flags |= MAP_POPULATE;
+#endif
+
+  char* addr = static_cast<char*>(mmap(nullptr, length, PROT_READ, flags, fd, 0u));
+
+  if (addr == MAP_FAILED) 
+  {
+    cerr << "cannot mmap " << fileName << " of length " << length << endl;
+    
+    throw;
+  }
+
+  char* mapping = addr;
+
+  if (length < 16) 
+  {
+    cerr << "relation file " << fileName << " does not contain a valid header" << endl;
+    
+    throw;
+  }
+
+
+  // Interpret header
+
+  this->size = *reinterpret_cast<uint64_t*>(addr); // The number of tuples
+  
+  addr += sizeof(size);
+  
+  auto numColumns=*reinterpret_cast<size_t*>(addr); // The number of columns
+  
+  addr += sizeof(size_t);
+
+  
+  // Store starting address of columns
+
+  for (unsigned i = 0; i < numColumns; i++) 
+  {
+    this->columns.push_back(reinterpret_cast<uint64_t*>(addr));
+    
+    addr += size*sizeof(uint64_t);
+  }
+
+#ifdef MULTI_THREAD_MODE
+  if (copyColumns)
+    placeColumns(mapping, length);
+#endif
+
+
+  // The statistics of the relation may be already made by the previous run
+  // Otherwise the zone maps are made now, the scans use them even without the other statistics
+
+  loadStatistics();
+
+  if (!statisticsLoaded)
+    BuildZoneMaps();
+
+#ifdef COMPRESSION_MODE
+  BuildCompressedColumns();
+#endif
+}
+
+
+#ifdef MULTI_THREAD_MODE
+// Copy the mapped columns to the memory on huge pages placed on the NUMA nodes, then unmap the file
+// Each column is split into the row ranges of the nodes, the same split as the morsels
+void Relation::placeColumns(char* mapping, uint64_t length)
+{
+  if (size == 0 || columns.empty())
+    return;
+
+  // Each column starts at 64 bytes, the mapping is aligned to a page
+
+  uint64_t stride = (size + 7) & ~7ull;
+
+  NodeMemory memory(columns.size() * stride * sizeof(uint64_t));
+
+  if (!memory.Data())
+    return;
+
+  uint64_t* placed = reinterpret_cast<uint64_t*>(memory.Data());
+
+  unsigned nodeCnt = Numa::NodeCount();
+
+
+  // Bind the ranges before they are touched, the binding decides where the pages are
+  // Then the chunks are copied in parallel, the copy faults every page in the preparation phase
+
+  for (unsigned c = 0; c < columns.size(); c++)
+  {
+    for (unsigned node = 0; node < nodeCnt; node++)
+    {
+      uint64_t start = Numa::NodeStart(node, size);
+
+      Numa::Bind(placed + c * stride + start, (Numa::NodeStart(node + 1, size) - start) * sizeof(uint64_t), node);
+    }
+  }
+
+  vector<future<void>> copies;
+
+  for (uint64_t start = 0; start < size; start += COPY_CHUNK_SIZE)
+  {
+    copies.push_back(threadpool.Request([this, placed, stride, start]()
+                                        {
+                                          uint64_t end = min(start + COPY_CHUNK_SIZE, size);
+
+                                          for (unsigned c = 0; c < columns.size(); c++)
+                                            memcpy(placed + c * stride + start, columns[c] + start, (end - start) * sizeof(uint64_t));
+                                        }));
+  }
+
+  for (auto& copy : copies)
+    threadpool.RequestWait(std::move(copy));
+
+  for (unsigned c = 0; c < columns.size(); c++)
+    columns[c] = placed + c * stride;
+
+  placedMemory = std::move(memory);
+
+  munmap(mapping, length);
+}
+#endif
+
+
+// Loads the statistics from the statistics file, if they are made from the same relation file
+void Relation::loadStatistics()
+{
+  StatisticsHeader expected;
+
+  if (!makeStatisticsHeader(fileName, size, columns.size(), expected))
+    return;
+
+
+  // Map the statistics file, it does not exist at the first run
+
+  int fd = open(statisticsFileName(fileName).c_str(), O_RDONLY);
+
+  if (fd == -1)
+    return;
+
+  struct stat sb;
+
+  if (fstat(fd, &sb) == -1 || sb.st_size < (off_t)sizeof(StatisticsHeader))
+  {
+    close(fd);
+
+    return;
+  }
+
+  char* addr = static_cast<char*>(mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0u));
+
+  close(fd);
+
+  if (addr == MAP_FAILED)
+    return;
+
+
+  // The statistics are stale if the relation file or the format is changed
+
+  StatisticsReader reader(addr, addr + sb.st_size);
+
+  StatisticsHeader header = {};
+
+  bool valid = reader.Read(header) && memcmp(&header, &expected, sizeof(header)) == 0;
+
+  vector<Histogram> loadedHistograms(columns.size());
+
+  vector<EquiDepthHistogram> loadedEquiDepthHistograms(header.flags & STATISTICS_EQUI_DEPTH ? columns.size() : 0);
+
+  vector<ZoneMap> loadedZoneMaps(columns.size());
+
+  for (unsigned colId = 0; colId < columns.size() && valid; colId++)
+  {
+    valid = loadedHistograms[colId].Load(reader);
+
+    if (valid && !loadedEquiDepthHistograms.empty())
+      valid = loadedEquiDepthHistograms[colId].Load(reader);
+
+    valid = valid && loadedZoneMaps[colId].Load(reader) && loadedZoneMaps[colId].mins.size() == (size + ZONE_SIZE - 1) / ZONE_SIZE;
+  }
+
+  valid = valid && reader.Done();
+
+  munmap(addr, sb.st_size);
+
+  if (!valid)
+    return;
+
+  histograms = move(loadedHistograms);
+
+  equiDepthHistograms = move(loadedEquiDepthHistograms);
+
+  zoneMaps = move(loadedZoneMaps);
+
+  statisticsLoaded = true;
+}
+
+
+// Stores the statistics to the statistics file
+void Relation::storeStatistics()
+{
+  StatisticsHeader header;
+
+  if (!makeStatisticsHeader(fileName, size, columns.size(), header))
+    return;
+
+
+  // Write to the temporary file then rename it, so the half-written file is never read
+  // If the directory is not writable, the statistics are just built again at the next run
+
+  string statisticsName = statisticsFileName(fileName);
+
+  string temporaryName = statisticsName + "." + to_string(getpid());
+
+  ofstream outFile(temporaryName, ios::out | ios::binary | ios::trunc);
+
+  if (!outFile)
+    return;
+
+  StatisticsWriter writer(outFile);
+
+  writer.Write(header);
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    histograms[colId].Save(writer);
+
+    if (!equiDepthHistograms.empty())
+      equiDepthHistograms[colId].Save(writer);
+
+    zoneMaps[colId].Save(writer);
+  }
+
+  outFile.close();
+
+  if (!outFile || rename(temporaryName.c_str(), statisticsName.c_str()) != 0)
+    unlink(temporaryName.c_str());
+}
+
+
+// Constructor that loads relation from disk
+Relation::Relation(const char* fileName) : ownsMemory(false), fileName(fileName)
+{
+  loadRelation(fileName);
+}
+
+
+// Destructor
+Relation::~Relation()
+{
+  if (ownsMemory) 
+  {
+    for (auto c : columns)
+      delete[] c;
+  }
+}
+
+
+/// Build histograms
+void Relation::BuildHistogram()
+{
+  if (statisticsLoaded)
+    return;
+
+
+  // The relation made in the memory has no zone maps yet
+
+  if (zoneMaps.empty())
+    BuildZoneMaps();
+
+
+  // Make histograms for each columns
+  // Then build it
+
+  histograms.resize(columns.size());
+
+#ifdef EQUI_DEPTH_HISTOGRAM_MODE
+  equiDepthHistograms.resize(columns.size());
+#endif
+
+#ifdef SINGLE_THREAD_MODE
+  for (int colId = 0; colId < columns.size(); colId++)
+  {
+    histograms[colId].Build(columns[colId], size);
+
+#ifdef EQUI_DEPTH_HISTOGRAM_MODE
+    equiDepthHistograms[colId].Build(columns[colId], size);
+
+    equiDepthHistograms[colId].SetDistinct(histograms[colId].GetDistinct());
+#endif
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+  // Each column is divided into the chunks, and all chunks of all columns are done in parallel
+  // The summaries of the chunks are merged for the range of the bars, then the chunks are counted in the bars
+
+  uint64_t chunkCnt = (size + HISTOGRAM_CHUNK_SIZE - 1) / HISTOGRAM_CHUNK_SIZE;
+
+  vector<ColumnSummary> summaries(columns.size() * chunkCnt);
+
+  vector<BarCounts> counts(columns.size() * chunkCnt);
+
+  vector<future<void>> works;
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    for (uint64_t chunk = 0; chunk < chunkCnt; chunk++)
+    {
+      works.push_back(threadpool.Request([this, &summaries, colId, chunk, chunkCnt]() {
+        uint64_t start = chunk * HISTOGRAM_CHUNK_SIZE, end = min(size, (chunk + 1) * HISTOGRAM_CHUNK_SIZE);
+
+        summaries[colId * chunkCnt + chunk].Add(columns[colId], start, end);
+      }));
+    }
+
+#ifdef EQUI_DEPTH_HISTOGRAM_MODE
+    // The sample is small, so the equi-depth histogram is one work for a column
+
+    works.push_back(threadpool.Request([this, colId]() { equiDepthHistograms[colId].Build(columns[colId], size); }));
+#endif
+  }
+
+  for (auto& work : works)
+    threadpool.RequestWait(move(work));
+
+  works.clear();
+
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    auto& summary = summaries[colId * chunkCnt];
+
+    for (uint64_t chunk = 1; chunk < chunkCnt; chunk++)
+      summary.Merge(summaries[colId * chunkCnt + chunk]);
+
+    histograms[colId].Prepare(columns[colId], summary);
+
+    for (uint64_t chunk = 0; chunk < chunkCnt; chunk++)
+    {
+      works.push_back(threadpool.Request([this, &counts, colId, chunk, chunkCnt]() {
+        histograms[colId].Count(columns[colId], chunk * HISTOGRAM_CHUNK_SIZE, min(size, (chunk + 1) * HISTOGRAM_CHUNK_SIZE), counts[colId * chunkCnt + chunk]);
+      }));
+    }
+  }
+
+  for (auto& work : works)
+    threadpool.RequestWait(move(work));
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    histograms[colId].Finish(&counts[colId * chunkCnt], chunkCnt);
+
+#ifdef EQUI_DEPTH_HISTOGRAM_MODE
+    // The sample misses the most of distinct values, so use the sketch of the whole column
+
+    equiDepthHistograms[colId].SetDistinct(histograms[colId].GetDistinct());
+#endif
+  }
+#endif
+
+
+  // Keep the statistics for the next run
+
+  storeStatistics();
+}
+
+
+/// Build zone maps
+void Relation::BuildZoneMaps()
+{
+  zoneMaps.resize(columns.size());
+
+  for (auto& zoneMap : zoneMaps)
+    zoneMap.Resize(size);
+
+#ifdef SINGLE_THREAD_MODE
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+    zoneMaps[colId].Build(columns[colId], 0, size);
+#endif
+#ifdef MULTI_THREAD_MODE
+  // The chunks of all columns are done in parallel, each chunk has its own zones
+
+  vector<future<void>> works;
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    for (uint64_t start = 0; start < size; start += ZONE_MAP_CHUNK_SIZE)
+    {
+      works.push_back(threadpool.Request([this, colId, start]() {
+        zoneMaps[colId].Build(columns[colId], start, min(size, start + ZONE_MAP_CHUNK_SIZE));
+      }));
+    }
+  }
+
+  for (auto& work : works)
+    threadpool.RequestWait(move(work));
+#endif
+}
+
+
+/// Build hash indexes
+void Relation::BuildIndexes()
+{
+  indexes.resize(columns.size());
+
+  // The distinct values are estimated by the histograms, and the row ids of the index are 32 bits
+
+  if (histograms.size() != columns.size() || size >= UINT32_MAX)
+    return;
+
+#ifdef SINGLE_THREAD_MODE
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    if (histograms[colId].GetDistinct() >= INDEX_DISTINCT_MIN * size)
+      indexes[colId].Build(columns[colId], size);
+  }
+#endif
+#ifdef MULTI_THREAD_MODE
+  // Each index is one work
+
+  vector<future<void>> works;
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+  {
+    if (histograms[colId].GetDistinct() >= INDEX_DISTINCT_MIN * size)
+      works.push_back(threadpool.Request([this, colId]() { indexes[colId].Build(columns[colId], size); }));
+  }
+
+  for (auto& work : works)
+    threadpool.RequestWait(move(work));
+#endif
+}
+
+
+/// Build compressed columns
+void Relation::BuildCompressedColumns()
+{
+  if (zoneMaps.empty())
+    BuildZoneMaps();
+
+  compressedColumns.resize(columns.size());
+
+
+  // The range of the column is the range of its zones
+
+  auto build = [this](unsigned colId)
+               {
+                 auto& zoneMap = zoneMaps[colId];
+
+                 if (zoneMap.mins.empty())
+                   return;
+
+                 uint64_t min = *std::min_element(zoneMap.mins.begin(), zoneMap.mins.end());
+
+                 uint64_t max = *std::max_element(zoneMap.maxs.begin(), zoneMap.maxs.end());
+
+                 compressedColumns[colId].Build(columns[colId], size, min, max);
+               };
+
+#ifdef SINGLE_THREAD_MODE
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+    build(colId);
+#endif
+#ifdef MULTI_THREAD_MODE
+  // Each column is one work
+
+  vector<future<void>> works;
+
+  for (unsigned colId = 0; colId < columns.size(); colId++)
+    works.push_back(threadpool.Request([&build, colId]() { build(colId); }));
+
+  for (auto& work : works)
+    threadpool.RequestWait(move(work));
+#endif
+}
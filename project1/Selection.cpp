@@ -0,0 +1,248 @@
+#include "Selection.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+// Compare the value with the constant
+template <FilterInfo::Comparison C>
+static inline bool compare(uint64_t value, uint64_t constant)
+{
+  switch (C)
+  {
+    case FilterInfo::Comparison::Equal:
+
+      return value == constant;
+
+    case FilterInfo::Comparison::Greater:
+
+      return value > constant;
+
+    case FilterInfo::Comparison::Less:
+
+      return value < constant;
+  };
+
+  return false;
+}
+
+// Select with the scalar loop
+// The offset is always written, and the count is increased only if the value is qualified
+// So there is no branch that depends on the data
+template <FilterInfo::Comparison C>
+static uint32_t selectScalar(const uint64_t* col, uint32_t count, uint64_t constant, uint32_t* sel)
+{
+  uint32_t selCount = 0;
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    sel[selCount] = i;
+
+    selCount += compare<C>(col[i], constant);
+  }
+
+  return selCount;
+}
+
+#if defined(__x86_64__)
+// The offsets of the set bits in the 4 bits mask, for the AVX2 kernel
+struct CompressTable
+{
+  alignas(16) uint32_t offsets[16][4];
+
+  constexpr CompressTable() : offsets()
+  {
+    for (unsigned mask = 0; mask < 16; mask++)
+    {
+      unsigned n = 0;
+
+      for (unsigned bit = 0; bit < 4; bit++)
+      {
+        if (mask & (1u << bit))
+          offsets[mask][n++] = bit;
+      }
+    }
+  }
+};
+
+static constexpr CompressTable compressTable;
+
+// Select with AVX2, 4 values at once
+// AVX2 has only signed 64 bit comparison, so flip the sign bits of both sides for the unsigned comparison
+template <FilterInfo::Comparison C>
+__attribute__((target("avx2")))
+static uint32_t selectAVX2(const uint64_t* col, uint32_t count, uint64_t constant, uint32_t* sel)
+{
+  const __m256i sign = _mm256_set1_epi64x(1ull << 63);
+
+  const __m256i constants = C == FilterInfo::Comparison::Equal ? _mm256_set1_epi64x(constant) : _mm256_set1_epi64x(constant ^ (1ull << 63));
+
+  uint32_t selCount = 0;
+
+  uint32_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+
+    __m256i result;
+
+    if (C == FilterInfo::Comparison::Equal)
+      result = _mm256_cmpeq_epi64(values, constants);
+    else if (C == FilterInfo::Comparison::Greater)
+      result = _mm256_cmpgt_epi64(_mm256_xor_si256(values, sign), constants);
+    else
+      result = _mm256_cmpgt_epi64(constants, _mm256_xor_si256(values, sign));
+
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(result));
+
+
+    // Write the offsets of the qualified values to the end of the selection vector
+    // It writes 4 offsets always, but the garbage after the count is overwritten by the next block
+
+    __m128i offsets = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(compressTable.offsets[mask])), _mm_set1_epi32(i));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sel + selCount), offsets);
+
+    selCount += __builtin_popcount(mask);
+  }
+
+  for (; i < count; i++)
+  {
+    sel[selCount] = i;
+
+    selCount += compare<C>(col[i], constant);
+  }
+
+  return selCount;
+}
+
+// Select with AVX-512, 8 values at once
+// The unsigned comparison and the compress store are supported directly
+template <FilterInfo::Comparison C>
+__attribute__((target("avx512f,avx512vl")))
+static uint32_t selectAVX512(const uint64_t* col, uint32_t count, uint64_t constant, uint32_t* sel)
+{
+  const __m512i constants = _mm512_set1_epi64(constant);
+
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  uint32_t selCount = 0;
+
+  uint32_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m512i values = _mm512_loadu_si512(col + i);
+
+    __mmask8 mask;
+
+    if (C == FilterInfo::Comparison::Equal)
+      mask = _mm512_cmpeq_epu64_mask(values, constants);
+    else if (C == FilterInfo::Comparison::Greater)
+      mask = _mm512_cmpgt_epu64_mask(values, constants);
+    else
+      mask = _mm512_cmplt_epu64_mask(values, constants);
+
+    _mm256_mask_compressstoreu_epi32(sel + selCount, mask, _mm256_add_epi32(lanes, _mm256_set1_epi32(i)));
+
+    selCount += __builtin_popcount(mask);
+  }
+
+  for (; i < count; i++)
+  {
+    sel[selCount] = i;
+
+    selCount += compare<C>(col[i], constant);
+  }
+
+  return selCount;
+}
+#endif
+
+using SelectFunction = uint32_t (*)(const uint64_t*, uint32_t, uint64_t, uint32_t*);
+
+// Choose the widest kernel that the cpu supports
+template <FilterInfo::Comparison C>
+static SelectFunction chooseKernel()
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+    return selectAVX512<C>;
+
+  if (__builtin_cpu_supports("avx2"))
+    return selectAVX2<C>;
+#endif
+
+  return selectScalar<C>;
+}
+
+// Select the offsets of values in col[0, count) which satisfy the comparison
+uint32_t Selection::Select(const uint64_t* col, uint32_t count, FilterInfo::Comparison comparison, uint64_t constant, uint32_t* sel)
+{
+  static const SelectFunction selectEqual = chooseKernel<FilterInfo::Comparison::Equal>();
+
+  static const SelectFunction selectGreater = chooseKernel<FilterInfo::Comparison::Greater>();
+
+  static const SelectFunction selectLess = chooseKernel<FilterInfo::Comparison::Less>();
+
+  switch (comparison)
+  {
+    case FilterInfo::Comparison::Equal:
+
+      return selectEqual(col, count, constant, sel);
+
+    case FilterInfo::Comparison::Greater:
+
+      return selectGreater(col, count, constant, sel);
+
+    case FilterInfo::Comparison::Less:
+
+      return selectLess(col, count, constant, sel);
+  };
+
+  return 0;
+}
+
+// Remove the offsets whose values do not satisfy the comparison
+// The selection vector is already sparse, so just compact it in place with the scalar loop
+template <FilterInfo::Comparison C>
+static uint32_t refine(const uint64_t* col, uint64_t constant, uint32_t* sel, uint32_t selCount)
+{
+  uint32_t remain = 0;
+
+  for (uint32_t i = 0; i < selCount; i++)
+  {
+    uint32_t offset = sel[i];
+
+    sel[remain] = offset;
+
+    remain += compare<C>(col[offset], constant);
+  }
+
+  return remain;
+}
+
+// Remove the offsets in sel[0, selCount) whose values do not satisfy the comparison
+uint32_t Selection::Refine(const uint64_t* col, FilterInfo::Comparison comparison, uint64_t constant, uint32_t* sel, uint32_t selCount)
+{
+  switch (comparison)
+  {
+    case FilterInfo::Comparison::Equal:
+
+      return refine<FilterInfo::Comparison::Equal>(col, constant, sel, selCount);
+
+    case FilterInfo::Comparison::Greater:
+
+      return refine<FilterInfo::Comparison::Greater>(col, constant, sel, selCount);
+
+    case FilterInfo::Comparison::Less:
+
+      return refine<FilterInfo::Comparison::Less>(col, constant, sel, selCount);
+  };
+
+  return 0;
+}
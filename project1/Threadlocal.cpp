@@ -0,0 +1,7 @@
+#include "Threadpool.hpp"
+
+thread_local ThreadPool* local_pool = nullptr; // The pool that this thread works for
+
+thread_local int local_worker_id = -1; // The index of this thread's deque in the pool
+
+thread_local int ThreadPool::steal_offset = 0;
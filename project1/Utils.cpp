@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "Utils.hpp"
+
+
+using namespace std;
+
+
+// Create a dummy column
+static void createColumn(vector<uint64_t*>& columns, uint64_t numTuples)
+{
+  auto col = new uint64_t[numTuples];
+  
+  columns.push_back(col);
+  
+  for (unsigned i = 0; i < numTuples; i++) 
+  {
+    col[i]=i;
+  }
+}
+
+// Create a dummy relation
+Relation Utils::createRelation(uint64_t size, uint64_t numColumns)
+{
+  vector<uint64_t*> columns;
+
+  for (unsigned i = 0; i < numColumns; i++) 
+  {
+    createColumn(columns,size);
+  }
+  
+  return Relation(size,move(columns));
+}
+
+// Create a column of the distribution
+static void createColumn(vector<uint64_t*>& columns, uint64_t numTuples, Utils::Distribution distribution, uint64_t distinct, mt19937_64& rng)
+{
+  auto col = new uint64_t[numTuples];
+
+  columns.push_back(col);
+
+  switch (distribution)
+  {
+    case Utils::Distribution::Sequential:
+
+      // Sorted, each value is repeated the same times
+
+      for (uint64_t i = 0; i < numTuples; i++)
+        col[i] = i * distinct / numTuples;
+
+      break;
+
+    case Utils::Distribution::Uniform:
+
+      // Every value once, then the duplicates drawn uniformly, then shuffled
+
+      for (uint64_t i = 0; i < numTuples; i++)
+        col[i] = i < distinct ? i : rng() % distinct;
+
+      shuffle(col, col + numTuples, rng);
+
+      break;
+
+    case Utils::Distribution::Zipf:
+    {
+      // The value v is drawn with the probability proportional to 1 / (v + 1), from the cumulative weights
+
+      vector<double> cumulative(distinct);
+
+      double total = 0;
+
+      for (uint64_t v = 0; v < distinct; v++)
+        cumulative[v] = total += 1.0 / (v + 1);
+
+      uniform_real_distribution<double> uniform(0, total);
+
+      for (uint64_t i = 0; i < numTuples; i++)
+        col[i] = min<uint64_t>(lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin(), distinct - 1);
+
+      break;
+    }
+  };
+}
+
+// Create a relation whose columns have the values of the distribution
+Relation Utils::createRelation(uint64_t size, uint64_t numColumns, Distribution distribution, double duplicateRate, uint64_t seed)
+{
+  uint64_t distinct = max<uint64_t>(llround(size * clamp(1 - duplicateRate, 0.0, 1.0)), 1);
+
+  mt19937_64 rng(seed);
+
+  vector<uint64_t*> columns;
+
+  for (unsigned i = 0; i < numColumns; i++)
+    createColumn(columns, size, distribution, distinct, rng);
+
+  return Relation(size, move(columns));
+}
+
+// Store a relation in all formats
+void Utils::storeRelation(ofstream& out, Relation& r, unsigned i)
+{
+  auto baseName = "r" + to_string(i);
+
+  r.storeRelation(baseName);
+  
+  r.storeRelationCSV(baseName);
+  
+  r.dumpSQL(baseName, i);
+  
+  cout << baseName << "\n";
+  
+  out << baseName << "\n";
+}
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Executeoptions.hpp"
+#include "Operators.hpp"
+#include "Threadpool.hpp"
+#include "Utils.hpp"
+
+
+using namespace std;
+
+
+// Micro-benchmarks of the operators on the generated relations
+// Each benchmark runs a fresh operator tree in a work of the pool, like the queries of Driver, and reports the median of the repetitions
+
+// The pool can not be resized, so one process runs one pool size
+// For each size of --threads, this program runs itself with BENCH_THREADS, then prints the CSV of all sizes with the speedup over the first size
+
+// usage: benchmark [--size N] [--distribution uniform|zipf|sequential] [--duplicates RATE] [--selectivity RATE]
+//                  [--threads 1,2,4] [--repetitions N] [--seed N]
+
+
+// The pool size of the child process, the parent process only waits
+static int poolSize()
+{
+  const char* threads = getenv("BENCH_THREADS");
+
+  return threads ? max(atoi(threads), 1) : 1;
+}
+
+ThreadPool threadpool(poolSize());
+
+
+/// The options of the benchmarks
+struct Options
+{
+  uint64_t size = 1 << 22;
+
+  string distribution = "uniform";
+
+  double duplicates = 0.5;
+
+  double selectivity = 0.1;
+
+  vector<int> threads;
+
+  unsigned repetitions = 5;
+
+  uint64_t seed = 42;
+};
+
+/// The result of a benchmark
+struct Measurement
+{
+  /// The tuples of the input, for the throughput
+  uint64_t tuples = 0;
+
+  /// The tuples of the result
+  uint64_t resultSize = 0;
+
+  /// The median of the repetitions, in milliseconds
+  double wallMs = 0;
+
+  /// The build and probe phases of the median repetition, recorded by the profile of the operator
+  double buildMs = 0;
+
+  double probeMs = 0;
+};
+
+
+// Run the operator tree made by make for the repetitions, after one warm-up
+// The tree runs in a work of the pool, so the pool size is the number of threads that work
+template <typename Make>
+static Measurement measure(unsigned repetitions, uint64_t tuples, Make&& make)
+{
+  struct Run
+  {
+    double wallMs, buildMs, probeMs;
+
+    uint64_t resultSize;
+  };
+
+  vector<Run> runs;
+
+  for (unsigned r = 0; r <= repetitions; r++)
+  {
+    Run run = threadpool.RequestGet(threadpool.Request([&make]()
+                                                       {
+                                                         Arena arena(threadpool.Size());
+
+                                                         unique_ptr<Operator> root = make();
+
+                                                         root->setArena(&arena);
+
+                                                         auto begin = chrono::steady_clock::now();
+
+                                                         root->run();
+
+                                                         double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+                                                         return Run{ wallMs, root->profile.buildWallNs / 1e6, root->profile.probeWallNs / 1e6, root->resultSize };
+                                                       }));
+
+    if (r > 0)
+      runs.push_back(run);
+  }
+
+  sort(runs.begin(), runs.end(), [](const Run& a, const Run& b) { return a.wallMs < b.wallMs; });
+
+  Run& median = runs[runs.size() / 2];
+
+  return Measurement{ tuples, median.resultSize, median.wallMs, median.buildMs, median.probeMs };
+}
+
+// The time of requesting and waiting an empty work, from a worker of the pool
+static Measurement measureTasks(unsigned repetitions)
+{
+  constexpr uint64_t TASK_CNT = 1 << 16;
+
+  vector<double> runs;
+
+  for (unsigned r = 0; r <= repetitions; r++)
+  {
+    double wallMs = threadpool.RequestGet(threadpool.Request([]()
+                                                             {
+                                                               vector<future<void>> tasks;
+
+                                                               tasks.reserve(TASK_CNT);
+
+                                                               auto begin = chrono::steady_clock::now();
+
+                                                               for (uint64_t i = 0; i < TASK_CNT; i++)
+                                                                 tasks.push_back(threadpool.Request([]() {}));
+
+                                                               for (auto& task : tasks)
+                                                                 threadpool.RequestWait(std::move(task));
+
+                                                               return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+                                                             }));
+
+    if (r > 0)
+      runs.push_back(wallMs);
+  }
+
+  sort(runs.begin(), runs.end());
+
+  return Measurement{ TASK_CNT, TASK_CNT, runs[runs.size() / 2], 0, 0 };
+}
+
+// The value that the given part of the column is less than
+static uint64_t quantile(const Relation& relation, unsigned colId, double part)
+{
+  vector<uint64_t> values(relation.columns[colId], relation.columns[colId] + relation.size);
+
+  uint64_t k = min<uint64_t>(part * values.size(), values.size() - 1);
+
+  nth_element(values.begin(), values.begin() + k, values.end());
+
+  return values[k];
+}
+
+// Prepare the statistics like the relations of Driver
+static void prepare(Relation& relation)
+{
+  relation.BuildHistogram();
+
+#ifdef COMPRESSION_MODE
+  relation.BuildCompressedColumns();
+#endif
+}
+
+// Run the benchmarks with this pool, one CSV line per benchmark without the speedup
+static void runBenchmarks(const Options& options)
+{
+  Utils::Distribution distribution = options.distribution == "zipf" ? Utils::Distribution::Zipf :
+                                     options.distribution == "sequential" ? Utils::Distribution::Sequential : Utils::Distribution::Uniform;
+
+  // The probe relation, and the build relation of a quarter of its size with the same keys
+
+  Relation probe = Utils::createRelation(options.size, 3, distribution, options.duplicates, options.seed);
+
+  Relation build = Utils::createRelation(max<uint64_t>(options.size / 4, 1), 2, distribution, options.duplicates, options.seed + 1);
+
+  prepare(probe);
+
+  prepare(build);
+
+  uint64_t constant = quantile(probe, 1, options.selectivity);
+
+  vector<pair<string, Measurement>> measurements;
+
+
+  // FilterScan of column 1 < the quantile of the selectivity
+
+  measurements.emplace_back("filterscan", measure(options.repetitions, probe.size, [&]()
+  {
+    auto scan = make_unique<FilterScan>(probe, vector<FilterInfo>{ FilterInfo(SelectInfo(0, 1), constant, FilterInfo::Comparison::Less) });
+
+    scan->require(SelectInfo(0, 0));
+
+    return unique_ptr<Operator>(move(scan));
+  }));
+
+
+  // Join of the build relation and the probe relation on column 0, the profile splits the build and the probe
+
+  PredicateInfo joinPredicate(SelectInfo(0, 0), SelectInfo(1, 0));
+
+  measurements.emplace_back("join", measure(options.repetitions, build.size + probe.size, [&]()
+  {
+    auto join = make_unique<Join>(make_unique<Scan>(build, 0), make_unique<Scan>(probe, 1), joinPredicate);
+
+    join->require(SelectInfo(0, 1));
+
+    join->require(SelectInfo(1, 1));
+
+    return unique_ptr<Operator>(move(join));
+  }));
+
+
+  // SelfJoin of column 1 = column 2 of the probe relation
+
+  PredicateInfo selfPredicate(SelectInfo(0, 1), SelectInfo(0, 2));
+
+  measurements.emplace_back("selfjoin", measure(options.repetitions, probe.size, [&]()
+  {
+    auto selfJoin = make_unique<SelfJoin>(make_unique<Scan>(probe, 0), selfPredicate);
+
+    selfJoin->require(SelectInfo(0, 0));
+
+    return unique_ptr<Operator>(move(selfJoin));
+  }));
+
+
+  // Checksum of two columns over the FilterScan
+
+  vector<SelectInfo> selections{ SelectInfo(0, 0), SelectInfo(0, 2) };
+
+  measurements.emplace_back("checksum", measure(options.repetitions, probe.size, [&]()
+  {
+    auto scan = make_unique<FilterScan>(probe, vector<FilterInfo>{ FilterInfo(SelectInfo(0, 1), constant, FilterInfo::Comparison::Less) });
+
+    return unique_ptr<Operator>(make_unique<Checksum>(move(scan), selections));
+  }));
+
+
+  // The pool itself
+
+  measurements.emplace_back("threadpool_task", measureTasks(options.repetitions));
+
+  for (auto& [name, m] : measurements)
+  {
+    cout << name << "," << threadpool.Size() << "," << options.distribution << "," << options.size << "," << options.duplicates << "," << options.selectivity << ","
+         << m.resultSize << "," << m.wallMs << "," << m.tuples / m.wallMs / 1000 << "," << m.buildMs << "," << m.probeMs << "\n";
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  // The profiles of the operators are recorded for the build and probe times
+
+  setenv("EXPLAIN_ANALYZE", "text", 0);
+
+  Options options;
+
+  string childArgs;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    string name = argv[i], value = argv[i + 1];
+
+    if (name == "--size")
+      options.size = max<uint64_t>(stoull(value), 1);
+    else if (name == "--distribution")
+      options.distribution = value;
+    else if (name == "--duplicates")
+      options.duplicates = clamp(stod(value), 0.0, 1.0);
+    else if (name == "--selectivity")
+      options.selectivity = clamp(stod(value), 0.0, 1.0);
+    else if (name == "--repetitions")
+      options.repetitions = max(stoi(value), 1);
+    else if (name == "--seed")
+      options.seed = stoull(value);
+    else if (name == "--threads")
+    {
+      stringstream list(value);
+
+      for (string count; getline(list, count, ',');)
+        options.threads.push_back(max(stoi(count), 1));
+
+      continue;
+    }
+    else
+    {
+      cerr << "unknown option " << name << endl;
+
+      return 1;
+    }
+
+    childArgs += " " + name + " " + value;
+  }
+
+
+  // The child runs the benchmarks with its pool
+
+  if (getenv("BENCH_THREADS"))
+  {
+    runBenchmarks(options);
+
+    return 0;
+  }
+
+  if (options.threads.empty())
+  {
+    for (int threads = 1; threads <= (int)thread::hardware_concurrency(); threads *= 2)
+      options.threads.push_back(threads);
+  }
+
+
+  // Run a child for each pool size, the speedup is over the first size with the same benchmark
+
+  cout << "benchmark,threads,distribution,size,duplicate_rate,selectivity,result_size,median_ms,mtuples_per_s,build_ms,probe_ms,speedup\n";
+
+  map<string, double> baseline;
+
+  char self[4096];
+
+  ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+
+  string program = length > 0 ? string(self, length) : argv[0];
+
+  for (int threads : options.threads)
+  {
+    string command = "BENCH_THREADS=" + to_string(threads) + " '" + program + "'" + childArgs;
+
+    FILE* child = popen(command.c_str(), "r");
+
+    if (!child)
+    {
+      cerr << "cannot run " << command << endl;
+
+      return 1;
+    }
+
+    char buffer[1024];
+
+    while (fgets(buffer, sizeof(buffer), child))
+    {
+      string line(buffer, strcspn(buffer, "\n"));
+
+      vector<string> fields;
+
+      stringstream stream(line);
+
+      for (string field; getline(stream, field, ',');)
+        fields.push_back(field);
+
+      string& name = fields[0];
+
+      double wallMs = stod(fields[7]);
+
+      if (!baseline.count(name))
+        baseline[name] = wallMs;
+
+      cout << line << "," << baseline[name] / wallMs << "\n" << flush;
+    }
+
+    pclose(child);
+  }
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+// Per-query arena for the intermediate results
+
+// Operators allocate their temporaries and result columns by bumping a pointer in a chunk,
+// and nothing is freed until the arena is destroyed at the end of the query
+// Then all chunks go back to the chunk pool at once
+
+// Each worker thread bumps its own chunk, so the allocations need no synchronization
+// The threads which are not workers of the pool share one chunk with the mutex
+
+// The chunk pool keeps the returned chunks, and gives them to the next queries
+// So the pages of the chunks are already faulted in and stay warm
+
+
+class ChunkPool
+{
+public:
+
+  /// The size of a normal chunk
+  static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+  /// The chunk pool does not keep more bytes than this
+  static constexpr size_t CACHE_MAX = size_t(1) << 30;
+
+  /// A chunk of memory
+  struct Chunk
+  {
+    char* data;
+
+    size_t size;
+  };
+
+  /// Get a chunk that has at least the given bytes
+  static Chunk Get(size_t bytes);
+
+  /// Give back the chunk for the next use
+  static void Put(Chunk chunk);
+
+};
+
+
+class Arena
+{
+public:
+
+  /// The constructor, workers of the pool have their own chunks
+  explicit Arena(int workerCnt);
+
+  /// The destructor, return all chunks to the pool
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+
+  Arena& operator=(const Arena&) = delete;
+
+  /// Allocate the bytes, aligned to the cache line
+  void* Allocate(size_t bytes);
+
+  /// Allocate the array
+  template <typename T>
+  T* Allocate(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T))); }
+
+private:
+
+  /// The chunks of a thread
+  struct alignas(64) Slot
+  {
+    char* now = nullptr;
+
+    char* end = nullptr;
+
+    std::vector<ChunkPool::Chunk> chunks;
+  };
+
+  /// Allocate from the slot
+  void* Allocate(Slot& slot, size_t bytes);
+
+  /// One slot for each worker, and the last one for the other threads
+  std::unique_ptr<Slot[]> slots;
+
+  int workerCnt;
+
+  std::mutex mutex;
+
+};
+
+
+/// Allocator that takes the memory from the arena
+/// Without the arena, it is same with std::allocator
+template <typename T>
+struct ArenaAllocator
+{
+  using value_type = T;
+
+  Arena* arena = nullptr;
+
+  ArenaAllocator() = default;
+
+  ArenaAllocator(Arena* arena) : arena(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& o) : arena(o.arena) {}
+
+  T* allocate(size_t n) { return arena ? arena->Allocate<T>(n) : std::allocator<T>().allocate(n); }
+
+  /// The memory of the arena is released with the arena
+  void deallocate(T* p, size_t n) { if (!arena) std::allocator<T>().deallocate(p, n); }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
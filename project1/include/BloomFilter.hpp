@@ -0,0 +1,81 @@
+#ifndef BLOOMFILTER_HPP
+#define BLOOMFILTER_HPP
+
+#include <memory>
+#include <stdint.h>
+
+
+// Register-blocked bloom filter for the sideways information passing of joins
+
+// The join builds the filter with the keys of the input that runs first,
+// then the FilterScan of the other input drops the tuples whose keys are not in the filter
+// So the tuples that can not have a partner are not materialized at all
+
+// All bits of a key are in one 64 bit block, so a lookup touches only one word
+// Upper bits of the hash select the block, and four 6 bit fields in the middle of the hash select the bits
+
+
+class BloomFilter
+{
+public:
+
+  /// Bits for one key
+  static constexpr uint64_t BITS_PER_KEY = 16;
+
+  /// The constructor, make the empty filter for the number of keys
+  BloomFilter(uint64_t keyCnt)
+  {
+    // The number of blocks is the power of 2
+
+    bits = 0;
+
+    while ((64ull << bits) < keyCnt * BITS_PER_KEY)
+      bits++;
+
+    shift = 64 - bits;
+
+    blocks = std::make_unique<uint64_t[]>(1ull << bits);
+  }
+
+  /// Add the key
+  inline void Insert(uint64_t key)
+  {
+    uint64_t hash = Hash(key);
+
+    blocks[Block(hash)] |= Mask(hash);
+  }
+
+  /// Whether the key can be in the filter
+  inline bool Contains(uint64_t key) const
+  {
+    uint64_t hash = Hash(key);
+
+    uint64_t mask = Mask(hash);
+
+    return (blocks[Block(hash)] & mask) == mask;
+  }
+
+private:
+
+  /// Multiplicative hashing, same with the hash table
+  static inline uint64_t Hash(uint64_t key) { return key * 0x9E3779B97F4A7C15ull; }
+
+  /// The block of the hash
+  inline uint64_t Block(uint64_t hash) const { return bits ? hash >> shift : 0; }
+
+  /// The bits of the hash in the block
+  static inline uint64_t Mask(uint64_t hash)
+  {
+    return (1ull << ((hash >> 4) & 63)) | (1ull << ((hash >> 10) & 63)) | (1ull << ((hash >> 16) & 63)) | (1ull << ((hash >> 22) & 63));
+  }
+
+
+  unsigned bits;
+
+  unsigned shift;
+
+  std::unique_ptr<uint64_t[]> blocks;
+
+};
+
+#endif  // BLOOMFILTER_HPP
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+struct FilterInfo;
+
+
+// Compressed copy of a column, for the scans
+
+// Each value is stored as a code of 1, 2 or 4 bytes, whichever is the smallest
+// Frame of reference: the code is the value minus the smallest value of the column
+// Dictionary: the code is the index of the value in the sorted distinct values, for the column of a few distinct values in a wide range
+
+// Both codes keep the order of the values, so a filter on the values is a filter on the codes with the translated constant
+// A block of codes is widened to 64 bits with AVX-512 or AVX2 (checked once at runtime), then the filter kernels of Selection run on it
+// The scan reads a half to an eighth of the bytes of the column
+
+// The raw column is kept, the operators still read the values by the row ids
+
+
+class CompressedColumn
+{
+public:
+
+  enum class Encoding { None, FrameOfReference, Dictionary };
+
+  /// The encoding, None if the column is not compressed
+  Encoding encoding = Encoding::None;
+
+  /// Whether the column is compressed
+  bool Compressed() const { return encoding != Encoding::None; }
+
+  /// Choose the encoding of the column whose values are in [min, max], then encode it
+  /// The encoding is None if no encoding is smaller than the raw column
+  void Build(const uint64_t* col, uint64_t size, uint64_t min, uint64_t max);
+
+  /// Widen the codes [start, start + count) to 64 bits, the codes are compared instead of the values
+  void DecodeCodes(uint64_t start, uint32_t count, uint64_t* out) const;
+
+  /// Translate the filter on the values to the filter on the codes
+  FilterInfo TranslateFilter(const FilterInfo& filter) const;
+
+private:
+
+  /// The bytes of a code, 1, 2 or 4
+  unsigned width = 8;
+
+  /// The smallest value, for the frame of reference
+  uint64_t base = 0;
+
+  /// The largest code
+  uint64_t maxCode = 0;
+
+  /// The sorted distinct values, for the dictionary
+  std::vector<uint64_t> dictionary;
+
+  /// The codes
+  std::vector<uint8_t> codes;
+
+};
@@ -0,0 +1,267 @@
+#ifndef EQUIDEPTHHISTOGRAM_HPP
+#define EQUIDEPTHHISTOGRAM_HPP
+
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdint.h>
+#include <vector>
+
+#include "Statistics.hpp"
+
+
+constexpr unsigned EQUI_DEPTH_BUCKET_COUNT = 100;
+
+constexpr uint64_t EQUI_DEPTH_SAMPLE_SIZE = 1 << 16;  // The tuples sampled to make the buckets
+
+
+// Equi-depth histogram, built from the random sample of the column
+
+// Each bucket has about the same number of tuples, so the dense ranges of the skewed column have the narrow buckets
+// A value that fills a bucket by itself has its own bucket, so the frequent values are estimated exactly like the sample
+// In a bucket, the values are assumed to be uniform over its distinct values
+
+
+class EquiDepthHistogram
+{
+public:
+
+  void Build(const uint64_t* arr, uint64_t size)
+  {
+    buckets.clear();
+
+    this->size = size;
+
+    if (!size)
+      return;
+
+
+    // Take the sample, or all values if the column is small
+
+    uint64_t sampleSize = size < EQUI_DEPTH_SAMPLE_SIZE ? size : EQUI_DEPTH_SAMPLE_SIZE;
+
+    std::vector<uint64_t> sample(sampleSize);
+
+    if (sampleSize == size)
+    {
+      std::copy(arr, arr + size, sample.begin());
+    }
+    else
+    {
+      std::mt19937_64 rng(size);
+
+      for (auto& value : sample)
+        value = arr[rng() % size];
+    }
+
+    std::sort(sample.begin(), sample.end());
+
+
+    // Cut the sorted sample into the buckets of the depth
+    // The same values are never split, and a value that is deeper than the bucket starts its own bucket
+
+    uint64_t depth = std::max<uint64_t>(sampleSize / EQUI_DEPTH_BUCKET_COUNT, 1);
+
+    double scale = (double)size / sampleSize;
+
+    for (uint64_t i = 0; i < sampleSize;)
+    {
+      uint64_t start = i;
+
+      uint64_t sampleDistinct = 0, singletons = 0;
+
+      while (i < sampleSize)
+      {
+        uint64_t runEnd = std::upper_bound(sample.begin() + i, sample.end(), sample[i]) - sample.begin();
+
+        if (runEnd - i >= depth && i > start)
+          break;
+
+        sampleDistinct++;
+
+        singletons += runEnd - i == 1;
+
+        i = runEnd;
+
+        if (i - start >= depth)
+          break;
+      }
+
+      Bucket bucket;
+
+      bucket.lower = sample[start];
+
+      bucket.upper = sample[i - 1];
+
+      bucket.fraction = (double)(i - start) / sampleSize;
+
+      bucket.repeated = sampleDistinct - singletons;
+
+      bucket.singletons = singletons;
+
+
+      // Scale up the distinct values of the sample (GEE)
+      // The values that are seen once in the sample may be one of many unseen values
+
+      bucket.distinct = Limit(bucket, std::sqrt(scale) * singletons + bucket.repeated);
+
+      buckets.push_back(bucket);
+    }
+  }
+
+  /// Share the number of distinct values of the whole column to the buckets
+  /// The values seen more than once in the sample are assumed to be all of their kind,
+  /// and the other values are shared in proportion to the singletons of the sample
+  void SetDistinct(double columnDistinct)
+  {
+    double repeated = 0, singletons = 0;
+
+    for (auto& bucket : buckets)
+    {
+      repeated += bucket.repeated;
+
+      singletons += bucket.singletons;
+    }
+
+    double unseen = std::max(columnDistinct - repeated, singletons);
+
+    for (auto& bucket : buckets)
+      bucket.distinct = Limit(bucket, bucket.repeated + (singletons ? unseen * bucket.singletons / singletons : 0));
+  }
+
+  /// The selectivity of values less than the value
+  double GetLowerSelectivity(uint64_t value) const
+  {
+    double selectivity = 0;
+
+    for (auto& bucket : buckets)
+    {
+      if (bucket.upper < value)
+        selectivity += bucket.fraction;
+      else if (bucket.lower < value)
+        selectivity += bucket.fraction * (value - bucket.lower) / ((double)(bucket.upper - bucket.lower) + 1);
+      else
+        break;
+    }
+
+    return selectivity;
+  }
+
+  /// The selectivity of values greater than the value
+  double GetUpperSelectivity(uint64_t value) const
+  {
+    double selectivity = 0;
+
+    for (auto bucket = buckets.rbegin(); bucket != buckets.rend(); ++bucket)
+    {
+      if (bucket->lower > value)
+        selectivity += bucket->fraction;
+      else if (bucket->upper > value)
+        selectivity += bucket->fraction * (bucket->upper - value) / ((double)(bucket->upper - bucket->lower) + 1);
+      else
+        break;
+    }
+
+    return selectivity;
+  }
+
+  /// The selectivity of the value
+  double GetEquiSelectivity(uint64_t value) const
+  {
+    auto bucket = std::lower_bound(buckets.begin(), buckets.end(), value, [](const Bucket& b, uint64_t v) { return b.upper < v; });
+
+    if (bucket == buckets.end() || bucket->lower > value)
+      return 0;
+
+    return bucket->fraction / bucket->distinct;
+  }
+
+  /// Store to the statistics file
+  void Save(StatisticsWriter& writer) const
+  {
+    writer.Write(size);
+
+    writer.Write(buckets);
+  }
+
+  /// Load from the statistics file
+  bool Load(StatisticsReader& reader)
+  {
+    return reader.Read(size) && reader.Read(buckets);
+  }
+
+  /// The selectivity of the equi-join with the other column
+  /// The overlapping parts of the buckets are compared, and a part has the values in proportion to its range
+  double GetJoinSelectivity(const EquiDepthHistogram& other) const
+  {
+    double selectivity = 0;
+
+    for (unsigned i = 0, j = 0; i < buckets.size() && j < other.buckets.size();)
+    {
+      auto& a = buckets[i];
+
+      auto& b = other.buckets[j];
+
+      uint64_t lower = std::max(a.lower, b.lower);
+
+      uint64_t upper = std::min(a.upper, b.upper);
+
+      if (lower <= upper)
+      {
+        double aPart = ((double)(upper - lower) + 1) / ((double)(a.upper - a.lower) + 1);
+
+        double bPart = ((double)(upper - lower) + 1) / ((double)(b.upper - b.lower) + 1);
+
+        double keys = std::max({ a.distinct * aPart, b.distinct * bPart, 1.0 });
+
+        selectivity += a.fraction * aPart * b.fraction * bPart / keys;
+      }
+
+      if (a.upper < b.upper)
+        i++;
+      else
+        j++;
+    }
+
+    return std::min(selectivity, 1.0);
+  }
+
+private:
+
+  struct Bucket
+  {
+    /// The smallest and the largest values
+    uint64_t lower;
+
+    uint64_t upper;
+
+    /// The part of the tuples in this bucket
+    double fraction;
+
+    /// The estimated number of distinct values
+    double distinct;
+
+    /// The distinct values of the sample, seen more than once and seen once
+    double repeated;
+
+    double singletons;
+  };
+
+  /// The distinct values of the bucket can not be more than its range and its tuples
+  double Limit(const Bucket& bucket, double distinct) const
+  {
+    distinct = std::min(distinct, (double)(bucket.upper - bucket.lower) + 1);
+
+    return std::max(std::min(distinct, bucket.fraction * size), 1.0);
+  }
+
+
+  uint64_t size = 0;
+
+  std::vector<Bucket> buckets;
+
+};
+
+
+#endif  // EQUIDEPTHHISTOGRAM_HPP
@@ -0,0 +1,42 @@
+#ifndef EXECUTEOPTIONS_HPP
+#define EXECUTEOPTIONS_HPP
+
+
+//#define SINGLE_THREAD_MODE
+
+#define MULTI_THREAD_MODE
+
+#define QUERY_OPTIMIZE_MODE
+
+#ifdef QUERY_OPTIMIZE_MODE
+#define EQUI_DEPTH_HISTOGRAM_MODE
+
+#define INDEX_JOIN_MODE
+
+#define PLAN_CACHE_MODE
+#endif
+
+#define COMPRESSION_MODE
+
+#define PREFAULT_MODE
+
+#ifdef MULTI_THREAD_MODE
+#define PIPELINE_MODE
+
+#define LATE_MATERIALIZATION_MODE
+
+#define NUMA_MODE
+#endif
+
+#ifdef LATE_MATERIALIZATION_MODE
+#define SHARED_SUBPLAN_MODE
+#endif
+
+#ifdef PREFAULT_MODE
+#ifdef MULTI_THREAD_MODE
+//#define HUGE_PAGE_MODE
+#endif
+#endif
+
+
+#endif  // EXECUTEOPTIONS_HPP
\ No newline at end of file
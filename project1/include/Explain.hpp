@@ -0,0 +1,139 @@
+#ifndef EXPLAIN_HPP
+#define EXPLAIN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+
+class Operator;
+
+class QueryInfo;
+
+
+// EXPLAIN ANALYZE of the queries
+// Set EXPLAIN_ANALYZE=text or EXPLAIN_ANALYZE=json, then the plan tree of each query is printed to stderr after it runs
+// When it is not set, an operator checks one cached flag per phase and nothing is timed or counted
+
+// Each operator has the wall time of its run, the wall and cpu time of its build and probe phases,
+// the actual and the expected result size, the size of its hash table, the number of its morsels and the bytes it materialized
+// The times of an operator include the inputs that it runs, the inputs of a join run in parallel
+// In pipeline mode the probes of the streamed operators run in the morsels of the checksum, so only their result sizes are counted
+
+
+/// The profile of an operator
+struct OperatorProfile
+{
+  /// The result size expected by the optimizer, negative if it is not estimated
+  double expectedSize = -1;
+
+  /// The wall time of the run, in nanoseconds
+  std::atomic<uint64_t> wallNs = 0;
+
+  /// The wall and cpu time of building the hash table
+  std::atomic<uint64_t> buildWallNs = 0, buildCpuNs = 0;
+
+  /// The wall and cpu time of the morsels, the cpu time is summed over the workers
+  std::atomic<uint64_t> probeWallNs = 0, probeCpuNs = 0;
+
+  /// The number of the morsels and the tasks
+  std::atomic<uint64_t> tasks = 0;
+
+  /// The tuples produced morsel by morsel when the operator is streamed
+  std::atomic<uint64_t> producedSize = 0;
+
+  /// The entries of the hash table or the index
+  uint64_t hashTableSize = 0;
+
+  /// The bytes of the materialized results
+  std::atomic<uint64_t> bytesMaterialized = 0;
+};
+
+
+class Explain
+{
+public:
+
+  enum class Format { Off, Text, Json };
+
+  /// The format asked by EXPLAIN_ANALYZE, read once
+  static Format Mode();
+
+  /// Whether the operators are profiled
+  static bool On() { return Mode() != Format::Off; }
+
+  /// The plan tree of the query with the profile of each operator
+  static std::string Dump(QueryInfo& query, Operator& root, Format format);
+
+  /// Print the plan tree to stderr, the trees of the concurrent queries are not mixed
+  static void Print(QueryInfo& query, Operator& root);
+
+};
+
+
+// Add the wall time of the scope to the counter, if the explain is on
+
+class WallTimer
+{
+public:
+
+  explicit WallTimer(std::atomic<uint64_t>& counter) : counter(Explain::On() ? &counter : nullptr)
+  {
+    if (this->counter)
+      start = std::chrono::steady_clock::now();
+  }
+
+  ~WallTimer()
+  {
+    if (counter)
+      *counter += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+
+  std::atomic<uint64_t>* counter;
+
+  std::chrono::steady_clock::time_point start;
+
+};
+
+
+// Add the cpu time of this thread in the scope to the counter, if the explain is on
+// The scope must not wait for the other works, they would run on this thread
+
+class CpuTimer
+{
+public:
+
+  explicit CpuTimer(std::atomic<uint64_t>& counter) : counter(Explain::On() ? &counter : nullptr)
+  {
+    if (this->counter)
+      start = Now();
+  }
+
+  ~CpuTimer()
+  {
+    if (counter)
+      *counter += Now() - start;
+  }
+
+private:
+
+  static uint64_t Now()
+  {
+    timespec time;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+    return time.tv_sec * 1000000000ull + time.tv_nsec;
+  }
+
+  std::atomic<uint64_t>* counter;
+
+  uint64_t start = 0;
+
+};
+
+#endif  // EXPLAIN_HPP
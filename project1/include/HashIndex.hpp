@@ -0,0 +1,96 @@
+#ifndef HASHINDEX_HPP
+#define HASHINDEX_HPP
+
+#include <stdint.h>
+#include <vector>
+
+
+constexpr double INDEX_DISTINCT_MIN = 0.5;  // The column has the index if its distinct values are at least this part of its tuples
+
+
+// Read-only hash index over a column of a base relation
+// It is built once in the preparation phase, then every query probes it without building the hash table
+
+// Like HashTable, the entries are sorted by bucket and the directory has the end offset of each bucket
+// The keys are copied next to the row ids, so a probe does not touch the base column for the other keys in the bucket
+// The row ids are 32 bits, the relation with more tuples has no index
+
+
+class HashIndex
+{
+public:
+
+  /// Whether the index is built
+  bool Built() const { return !directory.empty(); }
+
+  /// Build the index of the column, the row id of the key is its index
+  void Build(const uint64_t* col, uint64_t size)
+  {
+    // One bucket per tuple, at least two buckets so the shift is less than 64
+
+    uint64_t bucketCnt = 2;
+
+    for (shift = 63; bucketCnt < size; shift--)
+      bucketCnt <<= 1;
+
+    directory.assign(bucketCnt + 1, 0);
+
+
+    // Count the entries of each buckets, then change the counts to the end offsets
+
+    for (uint64_t i = 0; i < size; i++)
+      directory[Bucket(col[i])]++;
+
+    for (uint64_t b = 1; b <= bucketCnt; b++)
+      directory[b] += directory[b - 1];
+
+
+    // Scatter the entries backwards, so the end offset becomes the start offset
+    // and the row ids of a bucket are in ascending order
+
+    keys.resize(size);
+
+    rowIds.resize(size);
+
+    for (uint64_t i = size; i-- > 0;)
+    {
+      uint32_t offset = --directory[Bucket(col[i])];
+
+      keys[offset] = col[i];
+
+      rowIds[offset] = i;
+    }
+  }
+
+  /// Call f with the row id of each tuple that has the key
+  template <typename F>
+  inline void Probe(uint64_t key, F&& f) const
+  {
+    uint64_t bucket = Bucket(key);
+
+    for (uint32_t i = directory[bucket], end = directory[bucket + 1]; i < end; i++)
+    {
+      if (keys[i] == key)
+        f(rowIds[i]);
+    }
+  }
+
+private:
+
+  /// Multiplicative hashing like HashTable, the upper bits are the bucket
+  inline uint64_t Bucket(uint64_t key) const { return (key * 0x9E3779B97F4A7C15ull) >> shift; }
+
+
+  unsigned shift = 63;
+
+  /// The start offset of each bucket, the last one is the number of tuples
+  std::vector<uint32_t> directory;
+
+  /// The keys and the row ids of the entries, sorted by bucket
+  std::vector<uint64_t> keys;
+
+  std::vector<uint32_t> rowIds;
+
+};
+
+#endif  // HASHINDEX_HPP
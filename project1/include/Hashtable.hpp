@@ -0,0 +1,275 @@
+#ifndef HASHTABLE_HPP
+#define HASHTABLE_HPP
+
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+
+// Hash table for the build and probe phases of the join
+
+// std::unordered_multimap makes one heap node for every build tuple,
+// and every probe has to chase the pointers of the node list.
+// Instead, store all entries in one contiguous array which is sorted by bucket
+
+// The directory has one 8 byte slot per bucket
+// Lower 48 bits of the slot is the offset of the bucket's first entry in the entry array
+// The entries of the bucket end at the offset of the next slot, so duplicated keys need no extra node
+
+// Upper 16 bits of the slot is a tag (small bloom filter) of the keys in that bucket
+// Most of probes that have no partner can be finished by checking the tag, without touching the entries
+
+// For the large build side, the keys are radix partitioned with the upper bits of the hash,
+// then each partition has its own small table (PartitionedHashTable)
+// So the partitions can be built in parallel, and the table of one partition stays in the L2 cache
+
+
+class HashTable
+{
+public:
+
+  struct Entry
+  {
+    uint64_t key;
+
+    uint64_t rowId;
+  };
+
+  HashTable() {}
+
+  HashTable(const HashTable& h) = delete;
+
+  HashTable(HashTable&& h) = default;
+
+  HashTable& operator=(HashTable&& h) = default;
+
+  // Hash function
+  // Multiplicative hashing, so the upper bits are well mixed and used for the bucket
+  static inline uint64_t Hash(uint64_t key)
+  {
+    return key * 0x9E3779B97F4A7C15ull;
+  }
+
+  // Build the table with the keys, row id of the key is its index
+  void Build(uint64_t* keys, uint64_t size)
+  {
+    Reset(size, 0);
+
+
+    // Count the entries of each buckets and set the tags
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint64_t hash = Hash(keys[i]);
+
+      uint64_t& slot = directory[Bucket(hash)];
+
+      slot = (slot | Tag(hash)) + 1;
+    }
+
+
+    // Change the counts to the end offsets of buckets
+
+    Accumulate();
+
+
+    // Scatter the entries
+    // Decrease the end offset before writing, so it will be the start offset at the end
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint64_t& slot = directory[Bucket(Hash(keys[i]))];
+
+      entries[(--slot) & OFFSET_MASK] = Entry{ keys[i], i };
+    }
+  }
+
+  // Build the table with the entries of one radix partition
+  // The upper radix_bits of the hash are same in the partition, so the buckets use the bits under them
+  void Build(const Entry* input, uint64_t size, unsigned radix_bits)
+  {
+    Reset(size, radix_bits);
+
+
+    // Count the entries of each buckets and set the tags
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint64_t hash = Hash(input[i].key);
+
+      uint64_t& slot = directory[Bucket(hash)];
+
+      slot = (slot | Tag(hash)) + 1;
+    }
+
+
+    // Change the counts to the end offsets of buckets
+
+    Accumulate();
+
+
+    // Scatter the entries
+
+    for (uint64_t i = 0; i < size; i++)
+    {
+      uint64_t& slot = directory[Bucket(Hash(input[i].key))];
+
+      entries[(--slot) & OFFSET_MASK] = input[i];
+    }
+  }
+
+  // Call the function with the row id of every entry whose key is same with the given key
+  template <typename Function>
+  inline void Probe(uint64_t key, Function&& f) const
+  {
+    Probe(key, Hash(key), f);
+  }
+
+  // Probe with the hash that is already computed
+  template <typename Function>
+  inline void Probe(uint64_t key, uint64_t hash, Function&& f) const
+  {
+    uint64_t bucket = Bucket(hash);
+
+    uint64_t slot = directory[bucket];
+
+
+    // If the tag says that this key is not in the bucket, skip it
+
+    if (!(slot & Tag(hash)))
+      return;
+
+
+    // Compare the keys in the bucket
+
+    for (Entry* now = entries.get() + (slot & OFFSET_MASK), *end = entries.get() + (directory[bucket + 1] & OFFSET_MASK); now != end; now++)
+    {
+      if (now->key == key)
+        f(now->rowId);
+    }
+  }
+
+  // The number of entries
+  uint64_t Size() const { return size; }
+
+private:
+
+  static constexpr uint64_t OFFSET_MASK = (1ull << 48) - 1;
+
+  // Use upper bits of the hash for the bucket, except the radix bits
+  inline uint64_t Bucket(uint64_t hash) const
+  {
+    return (hash << radix_bits) >> shift;
+  }
+
+  // Use 4 bits under the bucket bits to select one bit of the 16 bits tag
+  inline uint64_t Tag(uint64_t hash) const
+  {
+    return 1ull << (48 + (((hash << radix_bits) >> (shift - 4)) & 15));
+  }
+
+  // Make the empty directory and entry array for the given size
+  void Reset(uint64_t size, unsigned radix_bits)
+  {
+    this->size = size;
+
+    this->radix_bits = radix_bits;
+
+
+    // The number of buckets is the power of 2 which is not smaller than the size
+
+    unsigned bits = 1;
+
+    while ((1ull << bits) < size)
+      bits++;
+
+    shift = 64 - bits;
+
+    bucket_count = 1ull << bits;
+
+
+    // The last slot is a sentinel that has the end offset of the last bucket
+
+    directory = std::make_unique<uint64_t[]>(bucket_count + 1);
+
+    entries = std::unique_ptr<Entry[]>(new Entry[size]);
+  }
+
+  // Change the counts of the directory to the end offsets, keeping the tags
+  void Accumulate()
+  {
+    uint64_t offset = 0;
+
+    for (uint64_t i = 0; i < bucket_count; i++)
+    {
+      offset += directory[i] & OFFSET_MASK;
+
+      directory[i] = (directory[i] & ~OFFSET_MASK) | offset;
+    }
+
+    directory[bucket_count] = offset;
+  }
+
+
+  uint64_t size = 0;
+
+  uint64_t bucket_count = 0;
+
+  unsigned shift = 63;
+
+  unsigned radix_bits = 0;
+
+  std::unique_ptr<uint64_t[]> directory;
+
+  std::unique_ptr<Entry[]> entries;
+
+};
+
+
+class PartitionedHashTable
+{
+public:
+
+  // Partition of the hash, upper radix_bits of the hash
+  static inline uint64_t Partition(uint64_t hash, unsigned radix_bits)
+  {
+    return radix_bits ? hash >> (64 - radix_bits) : 0;
+  }
+
+  // Make the empty partitions
+  void Reset(unsigned radix_bits)
+  {
+    this->radix_bits = radix_bits;
+
+    partitions.clear();
+
+    partitions.resize(1ull << radix_bits);
+  }
+
+  // Get the table of the partition
+  HashTable& operator[](uint64_t partition) { return partitions[partition]; }
+
+  // The number of partitions
+  uint64_t PartitionCount() const { return partitions.size(); }
+
+  // The number of radix bits
+  unsigned RadixBits() const { return radix_bits; }
+
+  // Route the key to the table of its partition
+  template <typename Function>
+  inline void Probe(uint64_t key, Function&& f) const
+  {
+    uint64_t hash = HashTable::Hash(key);
+
+    partitions[Partition(hash, radix_bits)].Probe(key, hash, f);
+  }
+
+private:
+
+  unsigned radix_bits = 0;
+
+  std::vector<HashTable> partitions;
+
+};
+
+#endif  // HASHTABLE_HPP
@@ -0,0 +1,598 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+
+#include <algorithm>
+#include <assert.h>
+#include <functional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "HyperLogLog.hpp"
+#include "Statistics.hpp"
+
+
+constexpr unsigned HISTOGRAM_BAR_COUNT = 100;
+
+constexpr unsigned MCV_CANDIDATE_COUNT = 32;  // The counters to find the most common values
+
+constexpr unsigned MCV_COUNT = 16;            // The most common values kept in the histogram
+
+constexpr unsigned MCV_SAMPLE_STRIDE = 16;    // Only every this tuple is counted to find the candidates
+
+constexpr unsigned MCV_SLOT_COUNT = 64;       // The slots of the hash table to count the candidates exactly
+
+
+// The first pass of the column, collected for each chunk and merged
+struct ColumnSummary
+{
+  uint64_t size = 0;
+
+  uint64_t min = UINT64_MAX;
+
+  uint64_t max = 0;
+
+  /// The sketch of the distinct values
+  HyperLogLog sketch;
+
+  /// The candidates of the most common values (Misra-Gries)
+  uint64_t candidates[MCV_CANDIDATE_COUNT] = {0};
+
+  uint64_t counters[MCV_CANDIDATE_COUNT] = {0};
+
+
+  /// Add the values of arr[start, end)
+  /// The common values are still common in the sample, so the candidates are found with every MCV_SAMPLE_STRIDE tuple
+  void Add(const uint64_t* arr, uint64_t start, uint64_t end)
+  {
+    size += end - start;
+
+    for (uint64_t i = start; i < end; i++)
+    {
+      max = max > arr[i] ? max : arr[i];
+
+      min = min < arr[i] ? min : arr[i];
+
+      sketch.Insert(arr[i]);
+    }
+
+    for (uint64_t i = (start + MCV_SAMPLE_STRIDE - 1) / MCV_SAMPLE_STRIDE * MCV_SAMPLE_STRIDE; i < end; i += MCV_SAMPLE_STRIDE)
+      CountCandidate(arr[i]);
+  }
+
+  /// Merge the summary of the other chunk
+  void Merge(const ColumnSummary& other)
+  {
+    size += other.size;
+
+    max = max > other.max ? max : other.max;
+
+    min = min < other.min ? min : other.min;
+
+    sketch.Merge(other.sketch);
+
+
+    // Add up the counters of the same values, then keep the largest ones
+    // The counters are decreased by the first dropped one, so the merged counters still never overestimate
+
+    std::pair<uint64_t, uint64_t> merged[MCV_CANDIDATE_COUNT * 2];
+
+    unsigned mergedCnt = 0;
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+    {
+      if (counters[c])
+        merged[mergedCnt++] = { counters[c], candidates[c] };
+    }
+
+    unsigned ownCnt = mergedCnt;
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+    {
+      if (!other.counters[c])
+        continue;
+
+      auto same = std::find_if(merged, merged + ownCnt, [&](auto& m) { return m.second == other.candidates[c]; });
+
+      if (same != merged + ownCnt)
+        same->first += other.counters[c];
+      else
+        merged[mergedCnt++] = { other.counters[c], other.candidates[c] };
+    }
+
+    uint64_t dropped = 0;
+
+    if (mergedCnt > MCV_CANDIDATE_COUNT)
+    {
+      std::nth_element(merged, merged + MCV_CANDIDATE_COUNT, merged + mergedCnt, std::greater<>());
+
+      dropped = merged[MCV_CANDIDATE_COUNT].first;
+
+      mergedCnt = MCV_CANDIDATE_COUNT;
+    }
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+    {
+      counters[c] = c < mergedCnt ? merged[c].first - dropped : 0;
+
+      candidates[c] = c < mergedCnt ? merged[c].second : 0;
+    }
+  }
+
+  /// Count the value with the candidates
+  /// Any value that is more than 1 / (MCV_CANDIDATE_COUNT + 1) of the counted tuples remains as the candidate
+  inline void CountCandidate(uint64_t value)
+  {
+    unsigned empty = MCV_CANDIDATE_COUNT;
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+    {
+      if (counters[c] && candidates[c] == value)
+      {
+        counters[c]++;
+
+        return;
+      }
+
+      if (!counters[c])
+        empty = c;
+    }
+
+    if (empty < MCV_CANDIDATE_COUNT)
+    {
+      candidates[empty] = value;
+
+      counters[empty] = 1;
+
+      return;
+    }
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+      counters[c]--;
+  }
+};
+
+// The second pass of the column, counted for each chunk and added up
+struct BarCounts
+{
+  uint64_t heights[HISTOGRAM_BAR_COUNT] = {0};
+
+  uint64_t mcvCounts[MCV_CANDIDATE_COUNT] = {0};
+};
+
+
+class Histogram
+{
+public:
+
+  Histogram() {}
+
+  ~Histogram() {}
+
+  Histogram(const Histogram& h)
+  {
+    this->arr = h.arr;
+
+    this->size = h.size;
+
+    for (int i = 0; i < HISTOGRAM_BAR_COUNT; i++)
+    {
+      this->heights[i] = h.heights[i];
+    }
+
+    this->max = h.max;
+
+    this->min = h.min;
+
+    this->width = h.width;
+
+    this->distinct = h.distinct;
+
+    this->mcvs = h.mcvs;
+
+    this->mcv_total = h.mcv_total;
+  }
+
+  Histogram(Histogram&& h)
+  {
+    this->arr = h.arr; h.arr = nullptr;
+
+    this->size = h.size; h.size = 0;
+
+    for (int i = 0; i < HISTOGRAM_BAR_COUNT; i++)
+    {
+      this->heights[i] = h.heights[i]; h.heights[i] = 0;
+    }
+
+    this->max = h.max; h.max = 0;
+
+    this->min = h.min; h.min = 0;
+
+    this->width = h.width; h.width = 0;
+
+    this->distinct = h.distinct; h.distinct = 0;
+
+    this->mcvs = std::move(h.mcvs);
+
+    this->mcv_total = h.mcv_total; h.mcv_total = 0;
+  }
+
+  void Build(uint64_t* arr, uint64_t size)
+  {
+    assert(arr != nullptr && size != 0);
+
+    // Build with one chunk of the whole column
+
+    ColumnSummary summary;
+
+    summary.Add(arr, 0, size);
+
+    Prepare(arr, summary);
+
+    BarCounts counts;
+
+    Count(arr, 0, size, counts);
+
+    Finish(&counts, 1);
+  }
+
+  // Set the range of the bars and the candidates of the most common values, with the summary of the whole column
+  void Prepare(uint64_t* arr, ColumnSummary& summary)
+  {
+    this->size = summary.size;
+
+    this->arr = arr;
+
+    max = summary.max;
+
+    min = summary.min;
+
+    distinct = summary.sketch.Estimate();
+
+    distinct = distinct < size ? distinct : size;
+    
+    uint64_t ceiled_max = 0;
+
+    uint64_t quotient = 0;
+
+
+    // Put the candidates to the small hash table, their exact counts are counted with the bars
+
+    mcvs.clear();
+
+    std::fill(slots, slots + MCV_SLOT_COUNT, -1);
+
+    for (unsigned c = 0; c < MCV_CANDIDATE_COUNT; c++)
+    {
+      if (!summary.counters[c])
+        continue;
+
+      uint64_t slot = Slot(summary.candidates[c]);
+
+      while (slots[slot] >= 0)
+        slot = (slot + 1) % MCV_SLOT_COUNT;
+
+      slots[slot] = mcvs.size();
+
+      mcvs.emplace_back(summary.candidates[c], 0);
+    }
+
+
+    // Before setting width, get the ceiled max
+
+    if ((max - min + 1) % HISTOGRAM_BAR_COUNT)
+    {
+      quotient = (max - min + 1) / HISTOGRAM_BAR_COUNT;
+
+      ceiled_max = (quotient + 1) * HISTOGRAM_BAR_COUNT + min;
+    }
+    else
+    {
+      ceiled_max = max;
+    }
+
+
+    // Set the width with ceiled max
+
+    width = (ceiled_max - min + 1) / HISTOGRAM_BAR_COUNT;
+  }
+
+  // Count the values of arr[start, end) in the bars and the candidates
+  void Count(const uint64_t* arr, uint64_t start, uint64_t end, BarCounts& counts) const
+  {
+    for (uint64_t i = start; i < end; i++)
+    {
+      uint64_t value = arr[i];
+
+      uint64_t index = (value - min) / width;
+
+      assert(index >= 0 || index < HISTOGRAM_BAR_COUNT);
+
+      counts.heights[index]++;
+
+      for (uint64_t slot = Slot(value); slots[slot] >= 0; slot = (slot + 1) % MCV_SLOT_COUNT)
+      {
+        if (mcvs[slots[slot]].first == value)
+        {
+          counts.mcvCounts[slots[slot]]++;
+
+          break;
+        }
+      }
+    }
+  }
+
+  // Add up the counts of the chunks, then keep the most common values
+  void Finish(const BarCounts* counts, unsigned countCnt)
+  {
+    for (unsigned c = 0; c < countCnt; c++)
+    {
+      for (int i = 0; i < HISTOGRAM_BAR_COUNT; i++)
+        heights[i] += counts[c].heights[i];
+
+      for (unsigned m = 0; m < mcvs.size(); m++)
+        mcvs[m].second += counts[c].mcvCounts[m];
+    }
+
+
+    // Keep the candidates that are more common than the average, at most MCV_COUNT of them
+
+    mcvs.erase(std::remove_if(mcvs.begin(), mcvs.end(), [&](auto& mcv) { return mcv.second < 2 || mcv.second * distinct <= 1.25 * size; }), mcvs.end());
+
+    if (mcvs.size() > MCV_COUNT)
+    {
+      std::nth_element(mcvs.begin(), mcvs.begin() + MCV_COUNT, mcvs.end(), [](auto& a, auto& b) { return a.second > b.second; });
+
+      mcvs.resize(MCV_COUNT);
+    }
+
+    std::sort(mcvs.begin(), mcvs.end());
+
+    mcv_total = 0;
+
+    for (auto& mcv : mcvs)
+      mcv_total += mcv.second;
+
+    distinct = distinct > mcvs.size() ? distinct : mcvs.size();
+  }
+
+  // The estimated number of distinct values
+  double GetDistinct() const { return distinct; }
+
+  // Store to the statistics file
+  void Save(StatisticsWriter& writer) const
+  {
+    writer.Write(size);
+
+    writer.Write(min);
+
+    writer.Write(max);
+
+    writer.Write(width);
+
+    writer.Write(heights, HISTOGRAM_BAR_COUNT);
+
+    writer.Write(distinct);
+
+    writer.Write<uint64_t>(mcvs.size());
+
+    for (auto& mcv : mcvs)
+    {
+      writer.Write(mcv.first);
+
+      writer.Write(mcv.second);
+    }
+  }
+
+  // Load from the statistics file
+  bool Load(StatisticsReader& reader)
+  {
+    uint64_t mcvCnt;
+
+    if (!reader.Read(size) || !reader.Read(min) || !reader.Read(max) || !reader.Read(width) || !reader.Read(heights, HISTOGRAM_BAR_COUNT) || !reader.Read(distinct) || !reader.Read(mcvCnt) || mcvCnt > MCV_COUNT)
+      return false;
+
+    mcvs.resize(mcvCnt);
+
+    mcv_total = 0;
+
+    for (auto& mcv : mcvs)
+    {
+      if (!reader.Read(mcv.first) || !reader.Read(mcv.second))
+        return false;
+
+      mcv_total += mcv.second;
+    }
+
+    return width != 0;
+  }
+
+  // Whether the value is one of the most common values
+  bool IsCommon(uint64_t value) const
+  {
+    return std::binary_search(mcvs.begin(), mcvs.end(), std::make_pair(value, uint64_t(0)), [](auto& a, auto& b) { return a.first < b.first; });
+  }
+
+  double GetUpperSelectivity(uint64_t value)
+  {
+    if (value > max || value < min)
+      return 0;
+      
+    uint64_t index = (value - min) / width;
+    
+    assert(index >= 0 || index < HISTOGRAM_BAR_COUNT);
+
+    uint64_t bar_max = (index + 1) * width + min - 1;
+
+    uint64_t bar_cnt = heights[index];
+
+    double upper_cnt = 0;
+
+
+    // Get the sum of heights that are higher than value's bar
+
+    for (int i = index + 1; i < HISTOGRAM_BAR_COUNT; i++)
+    {
+      upper_cnt += heights[i];
+    }
+
+    // Get the sum of count that are higher than inside of same bar
+
+    upper_cnt += (double)bar_cnt * (bar_max - value + 1) / width;
+
+
+    // Return selectivity
+
+    return (double)(upper_cnt) / size;
+  }
+
+  double GetLowerSelectivity(uint64_t value)
+  {
+    if (value > max || value < min)
+      return 0;
+
+    uint64_t index = (value - min) / width;
+
+    assert(index >= 0 || index < HISTOGRAM_BAR_COUNT);
+
+    uint64_t bar_min = index * width + min;
+
+    uint64_t bar_cnt = heights[index];
+
+    double lower_cnt = 0;
+
+
+    // Get the sum of heights that are lower than value's bar
+
+    for (int i = 0; i < index; i++)
+    {
+      lower_cnt += heights[i];
+    }
+
+    // Get the sum of count that are higher than inside of same bar
+
+    lower_cnt += (double)bar_cnt * (value - bar_min + 1) / width;
+
+
+    // Return selectivity
+
+    return (double)(lower_cnt) / size;
+  }
+
+  double GetEquiSelectivity(uint64_t value)
+  {
+    if (value > max || value < min)
+      return 0;
+
+    uint64_t index = (value - min) / width;
+
+    assert(index >= 0 || index < HISTOGRAM_BAR_COUNT);
+
+    if (!heights[index])
+      return 0;
+
+
+    // The most common value has its exact count
+    // Otherwise, the other values share the rest of tuples
+
+    auto mcv = std::lower_bound(mcvs.begin(), mcvs.end(), std::make_pair(value, uint64_t(0)));
+
+    if (mcv != mcvs.end() && mcv->first == value)
+      return (double)mcv->second / size;
+
+    return GetOtherEquiSelectivity();
+  }
+
+  double GetJoinSelectivity(const Histogram& other) const
+  {
+    if (!size || !other.size || max < other.min || other.max < min)
+      return 0;
+
+
+    // Merge the most common values of both sides, they are sorted by values
+    // The common values that are in both lists match exactly
+
+    double matched = 0, matched_freq = 0, other_matched_freq = 0;
+
+    for (unsigned i = 0, j = 0; i < mcvs.size() && j < other.mcvs.size();)
+    {
+      if (mcvs[i].first < other.mcvs[j].first)
+        i++;
+      else if (mcvs[i].first > other.mcvs[j].first)
+        j++;
+      else
+      {
+        double freq = (double)mcvs[i++].second / size;
+
+        double other_freq = (double)other.mcvs[j++].second / other.size;
+
+        matched += freq * other_freq;
+
+        matched_freq += freq;
+
+        other_matched_freq += other_freq;
+      }
+    }
+
+
+    // The common values that are only in one list match the other values of the other side
+    // And the other values of both sides match with the larger number of distinct values (containment)
+
+    double mcv_freq = (double)mcv_total / size, other_mcv_freq = (double)other.mcv_total / other.size;
+
+    double rest_distinct = std::max(distinct - mcvs.size(), 1.0), other_rest_distinct = std::max(other.distinct - other.mcvs.size(), 1.0);
+
+    double selectivity = matched
+      + (mcv_freq - matched_freq) * other.GetOtherEquiSelectivity()
+      + (other_mcv_freq - other_matched_freq) * GetOtherEquiSelectivity()
+      + (1 - mcv_freq) * (1 - other_mcv_freq) / std::max(rest_distinct, other_rest_distinct);
+
+
+    // Return selectivity
+
+    return std::min(selectivity, 1.0);
+  }
+
+private:
+
+  uint64_t* arr = nullptr;
+
+  uint64_t size = 0;
+
+  uint64_t max = 0;
+
+  uint64_t min = 0;
+
+  uint64_t heights[HISTOGRAM_BAR_COUNT] = {0};
+
+  uint64_t width = 0;
+
+  /// The estimated number of distinct values
+  double distinct = 0;
+
+  /// The most common values and their counts, sorted by values
+  std::vector<std::pair<uint64_t, uint64_t>> mcvs;
+
+  /// The sum of counts of the most common values
+  uint64_t mcv_total = 0;
+
+  /// The hash table of the candidates while building
+  int slots[MCV_SLOT_COUNT];
+
+
+  /// The slot of the value in the hash table of the candidates
+  static inline uint64_t Slot(uint64_t value) { return (value * 0x9E3779B97F4A7C15ull) >> (64 - __builtin_ctz(MCV_SLOT_COUNT)); }
+
+  /// The selectivity of a value that is not the most common value
+  double GetOtherEquiSelectivity() const
+  {
+    double rest_distinct = distinct - mcvs.size();
+
+    return rest_distinct >= 1 ? (double)(size - mcv_total) / size / rest_distinct : 0;
+  }
+
+};
+
+
+#endif  // HISTOGRAM_HPP
\ No newline at end of file
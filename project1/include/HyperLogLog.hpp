@@ -0,0 +1,100 @@
+#ifndef HYPERLOGLOG_HPP
+#define HYPERLOGLOG_HPP
+
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+
+// HyperLogLog sketch for the number of distinct values of a column
+
+// The first bits of the hash of a value select a register,
+// and the register keeps the longest run of leading zeros in the rest of the hash
+// The harmonic mean of the registers estimates the number of distinct values with the error about 1.04 / sqrt(REGISTER_COUNT)
+
+
+class HyperLogLog
+{
+public:
+
+  /// Bits of the hash for the register
+  static constexpr unsigned PRECISION = 12;
+
+  static constexpr unsigned REGISTER_COUNT = 1u << PRECISION;
+
+  /// The constructor, make the empty sketch
+  HyperLogLog() : registers(REGISTER_COUNT) {}
+
+  /// Add the value
+  inline void Insert(uint64_t value)
+  {
+    uint64_t hash = Hash(value);
+
+    uint64_t index = hash >> (64 - PRECISION);
+
+    // The guard bit limits the run of zeros to the bits after the index
+
+    uint8_t rank = __builtin_clzll((hash << PRECISION) | (1ull << (PRECISION - 1))) + 1;
+
+    if (rank > registers[index])
+      registers[index] = rank;
+  }
+
+  /// Merge the sketch of the other values, the result is same with the sketch of all values
+  void Merge(const HyperLogLog& other)
+  {
+    for (unsigned i = 0; i < REGISTER_COUNT; i++)
+      registers[i] = registers[i] > other.registers[i] ? registers[i] : other.registers[i];
+  }
+
+  /// The estimated number of distinct values
+  double Estimate() const
+  {
+    double sum = 0;
+
+    unsigned zeros = 0;
+
+    for (auto rank : registers)
+    {
+      sum += std::ldexp(1.0, -rank);
+
+      zeros += !rank;
+    }
+
+    double m = REGISTER_COUNT;
+
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+
+    // For the small number of values, linear counting of the empty registers is more accurate
+
+    if (estimate <= 2.5 * m && zeros)
+      estimate = m * std::log(m / zeros);
+
+    return estimate;
+  }
+
+private:
+
+  /// The finalizer of MurmurHash3, every bit of the value changes the leading bits
+  static inline uint64_t Hash(uint64_t key)
+  {
+    key ^= key >> 33;
+
+    key *= 0xff51afd7ed558ccdull;
+
+    key ^= key >> 33;
+
+    key *= 0xc4ceb9fe1a85ec53ull;
+
+    key ^= key >> 33;
+
+    return key;
+  }
+
+
+  std::vector<uint8_t> registers;
+
+};
+
+#endif  // HYPERLOGLOG_HPP
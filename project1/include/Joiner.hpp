@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "Parser.hpp"
+#include "Operators.hpp"
+#include "Relation.hpp"
+
+
+struct SharedResult;
+
+/// A subplan of a query that is done once for the batch of queries
+struct SharedInput
+{
+  /// The bindings of the query in the subplan, in the order of the relations of the result
+  std::vector<unsigned> bindings;
+
+  /// The result of the subplan
+  std::shared_ptr<const SharedResult> result;
+};
+
+
+/// A node of the plan of a query, the operators are made from the nodes
+/// The node refers the bindings and the predicates of the query by their indexes, so it has no constants of the filters
+struct PlanNode
+{
+  enum class Kind { Scan, SharedScan, Join, IndexJoin, SelfJoin };
+
+  Kind kind;
+
+  /// The binding of the scan or the indexed relation, or the index of the shared input
+  unsigned binding = 0;
+
+  /// The index of the predicate of the join
+  unsigned predicate = 0;
+
+  /// The input nodes, the left one is the outer input of the index join and the input of the self join
+  int left = -1;
+
+  int right = -1;
+
+  /// The result size expected by the optimizer
+  double expectedSize = -1;
+};
+
+/// The plan of a query, the root is the last node
+struct QueryPlan
+{
+  std::vector<PlanNode> nodes;
+
+  /// The expected size of each binding after its filters, when the plan was made
+  std::vector<double> scanSizes;
+};
+
+
+class Joiner 
+{
+public:
+
+  /// The relations that might be joined
+  std::vector<Relation> relations;
+
+  /// Add relation
+  void addRelation(const char* fileName);
+
+  /// Add the relations in the order of the files, they are loaded in parallel
+  void addRelations(const std::vector<std::string>& fileNames);
+
+  /// Get relation
+  Relation& getRelation(unsigned id);
+
+  /// Joins a given set of relations, the shared inputs are the subplans of the query that are already done
+  std::string join(QueryInfo& i, const std::vector<SharedInput>& sharedInputs = {});
+
+#ifdef SHARED_SUBPLAN_MODE
+  /// Joins the queries of a batch, the subplans common to the queries are done only once
+  std::vector<std::string> joinBatch(std::vector<QueryInfo>& queries);
+#endif
+
+  /// Optimize joins, make the join tree that has the smallest cost
+  std::unique_ptr<Operator> Optimize(QueryInfo& query, const std::vector<SharedInput>& sharedInputs = {});
+
+  /// Get selectivity
+  double GetSelectivity(SelectInfo& info, std::vector<FilterInfo>& filters);
+
+  /// Get selectivity
+  double GetSelectivity(FilterInfo& info);
+
+  /// Get selectivity
+  double GetSelectivity(PredicateInfo& info);
+
+private:
+
+  /// Add scan to query
+  std::unique_ptr<Operator> addScan(std::set<unsigned>& usedRelations,SelectInfo& info,QueryInfo& query,const std::vector<SharedInput>& sharedInputs);
+
+  /// The expected size of each binding after its filters
+  std::vector<double> estimateScanSizes(QueryInfo& query);
+
+  /// Find the cheapest plan of the query with the statistics
+  std::shared_ptr<const QueryPlan> planQuery(QueryInfo& query, const std::vector<SharedInput>& sharedInputs);
+
+  /// Make the operators of the node of the plan, with the constants of the query
+  std::unique_ptr<Operator> makeOperators(QueryInfo& query, const QueryPlan& plan, int node, std::set<unsigned>& usedRelations, const std::vector<SharedInput>& sharedInputs);
+
+#ifdef PLAN_CACHE_MODE
+  /// The plan of the template of the query, it is made once and reused by the queries with the other constants
+  std::shared_ptr<const QueryPlan> cachedPlan(QueryInfo& query);
+
+  /// The plans by the keys of the query templates
+  std::unordered_map<std::string, std::shared_ptr<const QueryPlan>> planCache;
+
+  std::mutex planCacheMutex;
+#endif
+
+  /// Make the left-deep join tree in the order of the predicates
+  std::unique_ptr<Operator> makeLeftDeepTree(QueryInfo& query, const std::vector<SharedInput>& sharedInputs);
+
+#ifdef SHARED_SUBPLAN_MODE
+  /// Whether the join of the two bindings is expected to be smaller than its inputs
+  bool isSmallJoin(QueryInfo& query, const std::vector<unsigned>& bindings);
+
+  /// Run the subplan of the bindings of the query, its result is shared by the queries that have the same subplan
+  std::shared_ptr<const SharedResult> runSharedSubplan(QueryInfo& query, const std::vector<unsigned>& bindings);
+#endif
+  
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+
+// NUMA awareness without libnuma
+
+// The nodes are read from /sys once, a machine without the topology has one node
+// The workers of the pool are pinned to the nodes round-robin
+// The columns of a loaded relation are split into the contiguous row ranges of the same size, each range is bound to one node
+// The morsels are split the same way, so a worker processes the rows of its own node first
+
+// With one node nothing is pinned, bound or copied, and the morsels have one cursor
+
+
+class Numa
+{
+public:
+
+  /// The number of the nodes that have cpus, 1 if the topology is unknown
+  static unsigned NodeCount();
+
+  /// The node that the worker of the pool is pinned to
+  static unsigned NodeOfWorker(int worker) { return worker % NodeCount(); }
+
+  /// The node of this thread, 0 if it is not pinned
+  static unsigned LocalNode();
+
+  /// Pin this thread to the cpus of the node
+  static void PinThread(unsigned node);
+
+  /// The first of the units [0, count) that the node owns
+  static uint64_t NodeStart(unsigned node, uint64_t count) { return count * node / NodeCount(); }
+
+  /// Bind the pages of [addr, addr + length) to the node, it must be done before the pages are touched
+  /// It is only a hint, the memory is still usable if the binding fails
+  static void Bind(void* addr, uint64_t length, unsigned node);
+
+};
+
+
+// Anonymous memory that is unmapped when it is deleted, for the columns placed on the nodes
+// It asks for the transparent huge pages, so the random reads by the row ids miss the TLB less
+
+class NodeMemory
+{
+public:
+
+  NodeMemory() = default;
+
+  /// Map the length bytes on huge pages, Data() is nullptr if it fails
+  explicit NodeMemory(uint64_t length);
+
+  NodeMemory(const NodeMemory& other) = delete;
+
+  NodeMemory(NodeMemory&& other) noexcept : addr(other.addr), length(other.length) { other.addr = nullptr; }
+
+  NodeMemory& operator=(NodeMemory&& other) noexcept;
+
+  ~NodeMemory();
+
+  char* Data() const { return addr; }
+
+private:
+
+  char* addr = nullptr;
+
+  uint64_t length = 0;
+
+};
+
+
+// Cursors over the units [0, count) split into the ranges of the nodes
+// A thread claims the units of its own node first, then helps the other nodes
+
+class NodeCursors
+{
+public:
+
+  explicit NodeCursors(uint64_t count) : count(count), cursors(Numa::NodeCount()) {}
+
+  /// Claim the next unit, false if every unit is claimed
+  bool Next(uint64_t& unit)
+  {
+    unsigned nodeCnt = cursors.size();
+
+    unsigned home = Numa::LocalNode();
+
+    for (unsigned i = 0; i < nodeCnt; i++)
+    {
+      unsigned node = (home + i) % nodeCnt;
+
+      uint64_t start = Numa::NodeStart(node, count);
+
+      uint64_t end = Numa::NodeStart(node + 1, count);
+
+      uint64_t claimed = start + cursors[node].value.fetch_add(1);
+
+      if (claimed < end)
+      {
+        unit = claimed;
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+private:
+
+  /// Each cursor has its own cache line, the nodes do not share it
+  struct alignas(64) Cursor
+  {
+    std::atomic<uint64_t> value = 0;
+  };
+
+  uint64_t count;
+
+  std::vector<Cursor> cursors;
+
+};
+
+#endif  // NUMA_HPP
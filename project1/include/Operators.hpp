@@ -0,0 +1,724 @@
+#pragma once
+
+#include <cassert>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <set>
+
+#include "Arena.hpp"
+#include "BloomFilter.hpp"
+#include "Executeoptions.hpp"
+#include "Explain.hpp"
+#include "Hashtable.hpp"
+#include "Parser.hpp"
+#include "Relation.hpp"
+
+
+namespace std 
+{
+  /// Simple hash function to enable use with unordered_map
+  template<> struct hash<SelectInfo> 
+  {
+    std::size_t operator()(SelectInfo const& s) const noexcept 
+    {
+      return s.binding ^ (s.colId << 5); 
+    }
+  };
+};
+
+
+/// The values of a result column
+/// In late materialization mode, the result has row ids of the base relation instead of the values
+struct ColumnRef
+{
+  /// The base column, or the materialized values
+  uint64_t* base = nullptr;
+
+  /// The row ids into the base column, nullptr if the index itself is the row id
+  uint64_t* rowIds = nullptr;
+
+  /// Get the i-th value
+  inline uint64_t operator[](uint64_t i) const { return rowIds ? base[rowIds[i]] : base[i]; }
+};
+
+
+/// The temporary result columns that grow while the tuples are copied
+using TmpResult = std::vector<ArenaVector<uint64_t>>;
+
+
+#ifdef PIPELINE_MODE
+/// Tuples of a morsel, the unit of pipelined execution
+struct Morsel
+{
+  /// The number of tuples
+  uint64_t size = 0;
+
+  /// The starting address of each columns, indexed like the materialized results
+  std::vector<uint64_t*> columns;
+
+  /// The storage of columns, if the operator has to copy the tuples
+  TmpResult buffers;
+
+  /// The morsel of the input operator, kept to reuse its storage
+  std::unique_ptr<Morsel> input;
+
+  /// Clear the buffers to copy new tuples
+  void clear(unsigned colCnt) { size = 0; buffers.resize(colCnt); for (auto& buffer : buffers) buffer.clear(); }
+
+  /// Point the columns to the buffers
+  void seal() { columns.clear(); for (auto& buffer : buffers) columns.push_back(buffer.data()); }
+
+  /// Get the tuples [start, end) of the materialized columns, the row ids are gathered into the buffers
+  void gather(std::vector<ColumnRef>& refs, uint64_t start, uint64_t end)
+  {
+    size = end - start;
+
+    columns.resize(refs.size());
+
+    buffers.resize(refs.size());
+
+    for (unsigned cId = 0; cId < refs.size(); cId++)
+    {
+      if (!refs[cId].rowIds)
+      {
+        columns[cId] = refs[cId].base + start;
+
+        continue;
+      }
+
+      buffers[cId].resize(size);
+
+      for (uint64_t i = start; i < end; i++)
+        buffers[cId][i - start] = refs[cId][i];
+
+      columns[cId] = buffers[cId].data();
+    }
+  }
+};
+#endif
+
+
+class FilterScan;
+
+class Operator 
+{
+  /// Operators materialize their entire result
+  /// In pipeline mode, the operators on the probe side of joins produce their result morsel by morsel instead
+  
+public:
+
+  /// Require a column and add it to results
+  virtual bool require(SelectInfo info) = 0;
+
+  /// Resolves a column
+  unsigned resolve(SelectInfo info) { assert(select2ResultColId.find(info) != select2ResultColId.end()); return select2ResultColId[info]; }
+
+  /// Run
+  virtual void run() = 0;
+
+  /// Get  materialized results
+  virtual std::vector<uint64_t*> getResults();
+
+  /// Get the values of a required column
+  ColumnRef getColumn(SelectInfo info) { return resultRefs[resolve(info)]; }
+
+  /// Get the values of all results, indexed like the results
+  std::vector<ColumnRef> getColumns() { return resultRefs; }
+
+  /// The result size
+  uint64_t resultSize=0;
+
+  /// Allocate the temporaries and results of this operator and its inputs from the arena
+  virtual void setArena(Arena* arena) { this->arena = arena; }
+
+  /// Fuse the checksum on top of this operator, the required columns are summed instead of materialized
+  /// Return false if this operator can not sum its result
+  virtual bool fuseChecksum() { return false; }
+
+  /// Whether the checksum is fused into this operator
+  bool checksumFused = false;
+
+  /// Find the FilterScan of the binding in this operator and its inputs, nullptr if there is not
+  virtual FilterScan* findFilterScan(unsigned binding) { return nullptr; }
+
+  /// The sums of the required columns, indexed like the results, when the checksum is fused
+  std::vector<uint64_t> resultSums;
+
+  /// The profile of this operator, recorded when the explain is on
+  OperatorProfile profile;
+
+  /// The name and the arguments of this operator, for the explain
+  virtual std::string explainName() { return "Operator"; }
+
+  /// The inputs of this operator, for the explain
+  virtual std::vector<Operator*> explainInputs() { return {}; }
+
+#ifdef PIPELINE_MODE
+  /// Whether this operator is a scan of a base relation
+  virtual bool isScan() { return false; }
+
+  /// Whether this operator can produce its result morsel by morsel
+  virtual bool streamable() { return false; }
+
+  /// Prepare the streaming, run the pipeline breakers below
+  virtual void open() {}
+
+  /// The number of tuples in the source relation that drives the pipeline
+  virtual uint64_t sourceSize() { return 0; }
+
+  /// Produce the result of the source tuples [start, end) into the morsel
+  virtual void produce(uint64_t start, uint64_t end, Morsel& morsel) {}
+#endif
+
+  /// The destructor
+  virtual ~Operator() 
+  {
+    // The memory of the arena is released with the arena
+
+    if (arena)
+      return;
+
+#ifdef MULTI_THREAD_MODE
+    for (uint64_t* col : tmpResults)
+    {
+      if (col)
+        delete[] col;
+    }
+#endif
+#ifdef LATE_MATERIALIZATION_MODE
+    for (uint64_t* col : rowIdResults)
+    {
+      if (col)
+        delete[] col;
+    }
+
+    for (uint64_t* col : gatheredResults)
+      delete[] col;
+#endif
+  }
+
+
+protected:  
+
+  /// The materialized results
+  std::vector<uint64_t*> resultColumns;         
+
+  /// The tmp results
+#ifdef SINGLE_THREAD_MODE
+  TmpResult tmpResults; 
+#endif
+#ifdef MULTI_THREAD_MODE
+  std::vector<uint64_t*> tmpResults; 
+#endif
+
+  /// Mapping from select info to data
+  std::unordered_map<SelectInfo, unsigned> select2ResultColId;
+
+  /// The values of the results, indexed like the results
+  std::vector<ColumnRef> resultRefs;
+
+  /// Refer the materialized values as the results
+  void referResults();
+
+  /// The arena of the query, nullptr if the results are allocated on the heap
+  Arena* arena = nullptr;
+
+  /// Allocate a result column
+  uint64_t* allocateColumn(uint64_t size) { return arena ? arena->Allocate<uint64_t>(size) : new uint64_t[size]; }
+
+#ifdef LATE_MATERIALIZATION_MODE
+  /// The row id columns of the results, one column per binding
+  std::vector<uint64_t*> rowIdResults;
+
+  /// The results gathered when getResults() is called
+  std::vector<uint64_t*> gatheredResults;
+#endif
+
+  /// Mutex
+  std::mutex mutex;
+  
+};
+
+class Scan : public Operator 
+{
+public:
+  
+  /// The constructor
+  Scan(Relation& r, unsigned relationBinding) : relation(r), relationBinding(relationBinding) {};
+  
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+  
+  /// Run
+  void run() override;
+  
+  /// Get  materialized results
+  virtual std::vector<uint64_t*> getResults() override;
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override { return "Scan " + std::to_string(relationBinding); }
+
+#ifdef PIPELINE_MODE
+  /// Whether this operator is a scan of a base relation
+  bool isScan() override { return true; }
+
+  /// Whether this operator can produce its result morsel by morsel
+  bool streamable() override { return true; }
+
+  /// The number of tuples in the source relation that drives the pipeline
+  uint64_t sourceSize() override { return relation.size; }
+
+  /// Produce the result of the source tuples [start, end) into the morsel
+  void produce(uint64_t start, uint64_t end, Morsel& morsel) override;
+#endif
+
+
+protected:
+  
+  /// The relation
+  Relation& relation;
+  
+  /// The name of the relation in the query
+  unsigned relationBinding;
+
+};
+
+class FilterScan : public Scan 
+{
+public:
+
+  /// The constructor
+  FilterScan(Relation& r, std::vector<FilterInfo> filters);
+
+  /// The constructor
+  FilterScan(Relation& r, FilterInfo& filterInfo) : FilterScan(r, std::vector<FilterInfo>{filterInfo}) {};
+
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+
+  /// Run
+  void run() override;
+
+  /// Get  materialized results
+  virtual std::vector<uint64_t*> getResults() override { return Operator::getResults(); }
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override;
+
+#ifdef PIPELINE_MODE
+  /// Produce the result of the source tuples [start, end) into the morsel
+  void produce(uint64_t start, uint64_t end, Morsel& morsel) override;
+#endif
+
+  /// Find the FilterScan of the binding
+  FilterScan* findFilterScan(unsigned binding) override { return binding == relationBinding ? this : nullptr; }
+
+  /// Drop the tuples whose values of the column are not in the bloom filter
+  void addBloomFilter(unsigned colId, std::shared_ptr<const BloomFilter> filter) { bloomFilters.emplace_back(colId, filter); }
+
+  /// The number of tuples in the relation
+  uint64_t relationSize() { return relation.size; }
+
+private:
+
+  /// The filter info
+  std::vector<FilterInfo> filters;
+
+#ifdef COMPRESSION_MODE
+  /// The first filter translated to the codes of its compressed column
+  FilterInfo firstCodeFilter;
+
+  /// The compressed column of the first filter, nullptr if the column is not compressed
+  const CompressedColumn* firstCodes = nullptr;
+#endif
+
+  /// The bloom filters pushed down from the joins above, with the column id of the relation
+  std::vector<std::pair<unsigned, std::shared_ptr<const BloomFilter>>> bloomFilters;
+  
+  /// The input data
+  std::vector<uint64_t*> inputData;
+  
+  /// How the tuples of a zone pass the filters, known from the zone maps
+  enum class ZoneMatch { None, Some, All };
+
+  /// Match the zone with the filters
+  ZoneMatch matchZone(uint64_t zone);
+
+  /// Select the tuples of the block [start, start + count) which pass all filters
+  uint32_t selectBlock(uint64_t start, uint32_t count, uint32_t* sel);
+
+  /// Copy all tuples [start, end) to result
+  void copyRange2Result(uint64_t start, uint64_t end, TmpResult& tmpResult);
+
+  /// Copy the row ids of all tuples [start, end) to result
+  void copyRangeRowIds2Result(uint64_t start, uint64_t end, TmpResult& tmpResult);
+
+  /// Copy the selected tuples of the block to result
+  void copy2Result(uint64_t start, const uint32_t* sel, uint32_t selCount, TmpResult& tmpResult);
+
+  /// Copy the row ids of the selected tuples of the block to result
+  void copyRowIds2Result(uint64_t start, const uint32_t* sel, uint32_t selCount, TmpResult& tmpResult);
+
+  /// Filter the tuples [start, end) and copy the passed tuples to result
+  uint64_t filter(uint64_t start, uint64_t end, TmpResult& tmpResult, bool copyRowIds);
+
+};
+
+#ifdef SHARED_SUBPLAN_MODE
+/// The result of a subplan that is shared by the queries of a batch
+/// The subplan runs once, and the consumers refer its row ids of each relation
+struct SharedResult
+{
+  /// The constructor
+  explicit SharedResult(int workerCnt) : arena(workerCnt) {}
+
+  /// The arena that has the row ids
+  Arena arena;
+
+  /// The row ids of each relation of the subplan, nullptr if the index itself is the row id
+  std::vector<uint64_t*> rowIds;
+
+  /// The number of tuples
+  uint64_t size = 0;
+};
+
+class SharedScan : public Operator
+{
+public:
+
+  /// The constructor, the bindings of the query are the relations of the shared result in order
+  SharedScan(std::shared_ptr<const SharedResult> shared, std::vector<Relation*> relations, std::vector<unsigned> bindings)
+    : shared(std::move(shared)), relations(std::move(relations)), bindings(std::move(bindings)) {}
+
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+
+  /// Run
+  void run() override;
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override;
+
+private:
+
+  /// The shared result, released when the last consumer is done
+  std::shared_ptr<const SharedResult> shared;
+
+  /// The relations of the shared result
+  std::vector<Relation*> relations;
+
+  /// The bindings of the relations in the query
+  std::vector<unsigned> bindings;
+
+  /// The relation of each result column
+  std::vector<unsigned> resultRelations;
+
+};
+#endif
+
+class Join : public Operator 
+{
+public:
+
+  /// The constructor
+  Join(std::unique_ptr<Operator>&& left, std::unique_ptr<Operator>&& right, PredicateInfo& pInfo) : left(std::move(left)), right(std::move(right)), pInfo(pInfo) {};
+
+  /// Allocate the temporaries and results of this operator and its inputs from the arena
+  void setArena(Arena* arena) override { this->arena = arena; left->setArena(arena); right->setArena(arena); }
+
+  /// Fuse the checksum, the matches are summed in the probe loop
+  bool fuseChecksum() override { checksumFused = true; return true; }
+
+  /// Find the FilterScan of the binding in the inputs
+  FilterScan* findFilterScan(unsigned binding) override { auto target = left->findFilterScan(binding); return target ? target : right->findFilterScan(binding); }
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override { return "Join " + pInfo.dumpText(); }
+
+  /// The inputs of this operator, for the explain
+  std::vector<Operator*> explainInputs() override { return { left.get(), right.get() }; }
+  
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+  
+  /// Run
+  void run() override;
+
+#ifdef PIPELINE_MODE
+  /// Whether this operator can produce its result morsel by morsel
+  bool streamable() override { return left->streamable() || right->streamable(); }
+
+  /// Prepare the streaming, build the hash table and open the probe side
+  void open() override;
+
+  /// The number of tuples in the source relation that drives the pipeline
+  uint64_t sourceSize() override { return buildEmpty ? 0 : rightMaterialized ? right->resultSize : right->sourceSize(); }
+
+  /// Produce the result of the source tuples [start, end) into the morsel
+  void produce(uint64_t start, uint64_t end, Morsel& morsel) override;
+#endif
+
+
+private:
+
+  /// The input operators
+  std::unique_ptr<Operator> left, right;
+  
+  /// The join predicate info
+  PredicateInfo& pInfo;
+  
+#ifdef SINGLE_THREAD_MODE
+  /// Copy tuple to result
+  void copy2Result(uint64_t leftId, uint64_t rightId);
+#endif
+#ifdef MULTI_THREAD_MODE
+  /// Copy tuple to result
+  inline void copy2Result(uint64_t leftId, uint64_t rightId, TmpResult& tmpResult);
+#endif
+#ifdef LATE_MATERIALIZATION_MODE
+  /// Copy row ids of tuple to result
+  inline void copyRowIds2Result(uint64_t leftId, uint64_t rightId, TmpResult& tmpResult);
+#endif
+
+  /// Create mapping for bindings
+  void createMappingForBindings();
+
+  /// Build the hash table with the keys
+  void buildHashTable(uint64_t* keys, uint64_t size);
+
+  /// Run the inputs one by one, and pass the bloom filter of the first one's keys to the FilterScan below the other
+  /// Return false if there is no FilterScan to pass the filter
+  bool runWithBloomFilter();
+
+  /// Build the bloom filter of the keys of the input, then push it down to the target
+  void pushBloomFilter(Operator& input, SelectInfo& key, FilterScan* target, SelectInfo& targetKey);
+
+  /// The hash table for the join
+  PartitionedHashTable hashTable;
+  
+  /// Columns that have to be materialized
+  std::unordered_set<SelectInfo> requestedColumns;
+  
+  /// Left/right columns that have been requested
+  std::vector<SelectInfo> requestedColumnsLeft,requestedColumnsRight;
+
+
+  /// The input data that has to be copied
+  std::vector<uint64_t*> copyLeftData,copyRightData;
+
+#ifdef LATE_MATERIALIZATION_MODE
+  /// The row id columns of the left/right bindings that have to be copied, nullptr if the index is the row id
+  std::vector<uint64_t*> copyLeftRowIds,copyRightRowIds;
+#endif
+
+#ifdef PIPELINE_MODE
+  /// The build side columns that have to be copied
+  std::vector<ColumnRef> copyLeftColumns;
+
+  /// The columns of the materialized probe side
+  std::vector<ColumnRef> rightInputColumns;
+
+  /// Whether the left input has to be streamed, the other side is built
+  bool probeLeft();
+
+  /// The columns of the probe side morsel that have to be copied
+  std::vector<unsigned> copyRightColIds;
+
+  /// The key column of the probe side morsel
+  unsigned rightKeyColId = 0;
+
+  /// Whether the build side has no tuple
+  bool buildEmpty = false;
+
+  /// Whether the probe side is materialized instead of streamed
+  bool rightMaterialized = false;
+#endif
+
+};
+
+#ifdef INDEX_JOIN_MODE
+class IndexJoin : public Operator
+{
+  /// Index nested-loop join
+  /// Each tuple of the left input probes the hash index of the base relation, the relation is never scanned
+
+public:
+
+  /// The constructor, the right key is the indexed column of the relation
+  IndexJoin(std::unique_ptr<Operator>&& left, Relation& relation, SelectInfo leftKey, SelectInfo rightKey)
+    : left(std::move(left)), relation(relation), index(relation.indexes[rightKey.colId]), leftKey(leftKey), rightKey(rightKey) {};
+
+  /// Allocate the temporaries and results of this operator and its inputs from the arena
+  void setArena(Arena* arena) override { this->arena = arena; left->setArena(arena); }
+
+  /// Fuse the checksum, the matches are summed in the probe loop
+  bool fuseChecksum() override { checksumFused = true; return true; }
+
+  /// Find the FilterScan of the binding in the left input, the relation has no filter
+  FilterScan* findFilterScan(unsigned binding) override { return left->findFilterScan(binding); }
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override { return "IndexJoin " + leftKey.dumpText() + "=" + rightKey.dumpText(); }
+
+  /// The inputs of this operator, for the explain
+  std::vector<Operator*> explainInputs() override { return { left.get() }; }
+
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+
+  /// Run
+  void run() override;
+
+
+private:
+
+  /// The left input
+  std::unique_ptr<Operator> left;
+
+  /// The indexed relation and its index
+  Relation& relation;
+
+  const HashIndex& index;
+
+  /// The join keys
+  SelectInfo leftKey, rightKey;
+
+  /// Columns that have to be materialized
+  std::unordered_set<SelectInfo> requestedColumns;
+
+  /// Left/right columns that have been requested
+  std::vector<SelectInfo> requestedColumnsLeft,requestedColumnsRight;
+
+};
+#endif
+
+class SelfJoin : public Operator
+{
+public:
+
+  /// The constructor
+  SelfJoin(std::unique_ptr<Operator>&& input, PredicateInfo& pInfo) : input(std::move(input)), pInfo(pInfo) {};
+
+  /// Allocate the temporaries and results of this operator and its inputs from the arena
+  void setArena(Arena* arena) override { this->arena = arena; input->setArena(arena); }
+
+  /// Fuse the checksum, the passed tuples are summed in the comparing loop
+  bool fuseChecksum() override { checksumFused = true; return true; }
+
+  /// Find the FilterScan of the binding in the input
+  FilterScan* findFilterScan(unsigned binding) override { return input->findFilterScan(binding); }
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override { return "SelfJoin " + pInfo.dumpText(); }
+
+  /// The inputs of this operator, for the explain
+  std::vector<Operator*> explainInputs() override { return { input.get() }; }
+
+  /// Require a column and add it to results
+  bool require(SelectInfo info) override;
+
+  /// Run
+  void run() override;
+
+#ifdef PIPELINE_MODE
+  /// Whether this operator can produce its result morsel by morsel
+  bool streamable() override { return input->streamable(); }
+
+  /// Prepare the streaming, open the input
+  void open() override;
+
+  /// The number of tuples in the source relation that drives the pipeline
+  uint64_t sourceSize() override { return input->sourceSize(); }
+
+  /// Produce the result of the source tuples [start, end) into the morsel
+  void produce(uint64_t start, uint64_t end, Morsel& morsel) override;
+#endif
+
+private:
+
+  /// The input operators
+  std::unique_ptr<Operator> input;
+  
+  /// The join predicate info
+  PredicateInfo& pInfo;
+  
+#ifdef SINGLE_THREAD_MODE
+  /// Copy tuple to result
+  void copy2Result(uint64_t id);
+#endif
+#ifdef MULTI_THREAD_MODE
+  /// Copy tuple to result
+  inline void copy2Result(uint64_t id, TmpResult& tmpResult);
+#endif
+#ifdef LATE_MATERIALIZATION_MODE
+  /// Copy row ids of tuple to result
+  inline void copyRowIds2Result(uint64_t id, TmpResult& tmpResult);
+#endif
+  
+  /// The required IUs
+  std::set<SelectInfo> requiredIUs;
+
+  /// The entire input data
+  std::vector<uint64_t*> inputData;
+  
+  /// The input data that has to be copied
+  std::vector<uint64_t*> copyData;
+
+#ifdef LATE_MATERIALIZATION_MODE
+  /// The row id columns of the bindings that have to be copied, nullptr if the index is the row id
+  std::vector<uint64_t*> copyRowIds;
+#endif
+
+#ifdef PIPELINE_MODE
+  /// The columns of the input morsel that have to be copied
+  std::vector<unsigned> copyColIds;
+
+  /// The key columns of the input morsel
+  unsigned leftColId = 0, rightColId = 0;
+#endif
+};
+
+class Checksum : public Operator 
+{
+public:
+
+  std::vector<uint64_t> checkSums;
+
+  /// The constructor
+  Checksum(std::unique_ptr<Operator>&& input, std::vector<SelectInfo>& colInfo) : input(std::move(input)), colInfo(colInfo) {};
+
+  /// Allocate the temporaries and results of this operator and its inputs from the arena
+  void setArena(Arena* arena) override { this->arena = arena; input->setArena(arena); }
+
+  /// Request a column and add it to results
+  bool require(SelectInfo info) override { throw; /* check sum is always on the highest level and thus should never request anything */ }
+
+  /// The name and the arguments of this operator, for the explain
+  std::string explainName() override { return "Checksum"; }
+
+  /// The inputs of this operator, for the explain
+  std::vector<Operator*> explainInputs() override { return { input.get() }; }
+
+  /// Run
+  void run() override;
+
+private:
+
+  /// The input operator
+  std::unique_ptr<Operator> input;
+
+  /// The join predicate info
+  std::vector<SelectInfo>& colInfo;
+
+#ifdef PIPELINE_MODE
+  /// Sum the columns while the morsels flow from the input
+  void runPipeline();
+#endif
+
+};
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Vectorized sum kernels of Checksum
+
+// A column is summed block by block, so the rows of a block are read once for all the selected columns
+// The values are added in the 64 bit lanes, which wrap around like the scalar additions,
+// so the partial sums of the lanes and the workers can be merged in any order and give the same checksum
+
+// The kernel uses AVX-512 or AVX2 if the cpu supports it (checked once at runtime),
+// otherwise the scalar loop
+
+
+class Reduction
+{
+public:
+
+  /// The number of tuples in one block
+  static constexpr uint32_t BLOCK_SIZE = 1024;
+
+  /// The sum of col[0, count), or of col[rowIds[0, count)] if the row ids are given
+  static uint64_t Sum(const uint64_t* col, const uint64_t* rowIds, uint32_t count);
+
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CompressedColumn.hpp"
+#include "EquiDepthHistogram.hpp"
+#include "HashIndex.hpp"
+#include "Histogram.hpp"
+#include "Numa.hpp"
+#include "ZoneMap.hpp"
+
+
+using RelationId = unsigned;
+
+
+class Relation 
+{
+public:
+
+  /// The number of tuples
+  uint64_t size;
+
+  /// The join column containing the keys
+  std::vector<uint64_t*> columns;
+
+  /// Stores a relation into a file (binary)
+  void storeRelation(const std::string& fileName);
+
+  /// Stores a relation into a file (csv)
+  void storeRelationCSV(const std::string& fileName);
+  
+  /// Dump SQL: Create and load table (PostgreSQL)
+  void dumpSQL(const std::string& fileName,unsigned relationId);
+
+  /// Constructor without mmap
+  Relation(uint64_t size,std::vector<uint64_t*>&& columns) : ownsMemory(true), size(size), columns(columns) {}
+  
+  /// Constructor using mmap
+  Relation(const char* fileName);
+  
+  /// Delete copy constructor
+  Relation(const Relation& other)=delete;
+  
+  /// Move constructor
+  Relation(Relation&& other)=default;
+  
+  /// The destructor
+  ~Relation();
+
+  /// Histogram for each columns
+  std::vector<Histogram> histograms;
+
+  /// Equi-depth histogram for each columns, empty if it is not built
+  std::vector<EquiDepthHistogram> equiDepthHistograms;
+
+  /// Zone map for each columns
+  std::vector<ZoneMap> zoneMaps;
+
+  /// Build histograms and zone maps, then store them to the statistics file
+  /// Nothing is done if they are loaded from the statistics file
+  void BuildHistogram();
+
+  /// Build zone maps, it is done when the relation is loaded from a file
+  void BuildZoneMaps();
+
+  /// Compressed copy of each columns, for the scans
+  std::vector<CompressedColumn> compressedColumns;
+
+  /// Compress the columns, with the ranges of the zone maps
+  void BuildCompressedColumns();
+
+  /// Hash index for each columns, not built if the column is not key-like
+  std::vector<HashIndex> indexes;
+
+  /// Build the hash indexes of the columns that have mostly distinct values, after the histograms
+  void BuildIndexes();
+
+private:
+
+  /// Owns memory (false if it was mmaped)
+  bool ownsMemory;
+
+  /// The copy of the columns on huge pages whose row ranges are bound to the NUMA nodes, empty if the columns are read from the file mapping
+  NodeMemory placedMemory;
+
+  /// The relation file, empty if it is not loaded from a file
+  std::string fileName;
+
+  /// Whether the statistics are loaded from the statistics file
+  bool statisticsLoaded = false;
+  
+  /// Loads data from a file
+  void loadRelation(const char* fileName);
+
+  /// Copy the mapped columns to the memory on huge pages placed on the NUMA nodes, then unmap the file
+  void placeColumns(char* mapping, uint64_t length);
+
+  /// Loads the statistics from the statistics file, if they are made from the same relation file
+  void loadStatistics();
+
+  /// Stores the statistics to the statistics file
+  void storeStatistics();
+  
+};
\ No newline at end of file
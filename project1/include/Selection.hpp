@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Parser.hpp"
+
+
+// Vectorized filter kernels of FilterScan
+
+// The filter is evaluated over a block of the column at once,
+// and the result is a selection vector, the offsets of the qualifying tuples in the block
+// The first filter scans the block densely, the others only refine the selection vector
+// Then the required columns are gathered with the selection vector in bulk
+
+// The dense kernel uses AVX-512 or AVX2 if the cpu supports it (checked once at runtime),
+// otherwise the branch-free scalar loop
+
+
+class Selection
+{
+public:
+
+  /// The number of tuples in one block
+  static constexpr uint32_t BLOCK_SIZE = 1024;
+
+  /// Select the offsets of values in col[0, count) which satisfy the comparison
+  /// Return the number of selected offsets
+  static uint32_t Select(const uint64_t* col, uint32_t count, FilterInfo::Comparison comparison, uint64_t constant, uint32_t* sel);
+
+  /// Remove the offsets in sel[0, selCount) whose values do not satisfy the comparison
+  /// Return the number of remaining offsets
+  static uint32_t Refine(const uint64_t* col, FilterInfo::Comparison comparison, uint64_t constant, uint32_t* sel, uint32_t selCount);
+
+};
@@ -0,0 +1,88 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <cstring>
+#include <ostream>
+#include <stdint.h>
+#include <vector>
+
+
+// The statistics of a relation are stored in the sidecar file next to the relation file
+// These are the writer and the reader of its binary format, the values are stored as they are in the memory
+
+
+class StatisticsWriter
+{
+public:
+
+  StatisticsWriter(std::ostream& out) : out(out) {}
+
+  /// Write the value
+  template <typename T>
+  void Write(const T& value) { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+  /// Write the array
+  template <typename T>
+  void Write(const T* values, uint64_t count) { out.write(reinterpret_cast<const char*>(values), count * sizeof(T)); }
+
+  /// Write the size of the vector, then its elements
+  template <typename T>
+  void Write(const std::vector<T>& values) { Write<uint64_t>(values.size()); Write(values.data(), values.size()); }
+
+private:
+
+  std::ostream& out;
+
+};
+
+
+class StatisticsReader
+{
+public:
+
+  StatisticsReader(const char* data, const char* end) : data(data), end(end) {}
+
+  /// Read the value, false if the file is too short
+  template <typename T>
+  bool Read(T& value) { return Read(&value, 1); }
+
+  /// Read the array, false if the file is too short
+  template <typename T>
+  bool Read(T* values, uint64_t count)
+  {
+    if (uint64_t(end - data) / sizeof(T) < count)
+      return false;
+
+    std::memcpy(values, data, count * sizeof(T));
+
+    data += count * sizeof(T);
+
+    return true;
+  }
+
+  /// Read the vector that is written with its size
+  template <typename T>
+  bool Read(std::vector<T>& values)
+  {
+    uint64_t count;
+
+    if (!Read(count) || uint64_t(end - data) / sizeof(T) < count)
+      return false;
+
+    values.resize(count);
+
+    return Read(values.data(), count);
+  }
+
+  /// Whether all bytes are read
+  bool Done() const { return data == end; }
+
+private:
+
+  const char* data;
+
+  const char* end;
+
+};
+
+#endif  // STATISTICS_HPP
@@ -0,0 +1,397 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Executeoptions.hpp"
+#include "Numa.hpp"
+#include "Workstore.hpp"
+
+
+// To reduce the cost of creation and deletion of threads
+// Use thread pool
+
+// Once thread is created, it will be not deleted until destructor is called.
+
+// Work stealing scheduler
+// Each worker has its own deque. The works requested by a worker are pushed to its deque,
+// and the works requested outside of the pool are pushed to the shared work-store
+// A worker pops its own deque first, then loads the work-store, then steals the other deques
+// If there are no work anywhere, the worker parks on the condition variable until new work is made
+
+// A worker that waits a future does not block, it runs the other works until the future is ready
+// If there is no work to run, the awaited work is running on the other worker,
+// so the waiter parks like an idle worker until a work is finished or pushed, then checks the future again
+// So the pool never needs more threads than its size, which is the number of the cores
+
+// On the machine of several NUMA nodes, each worker is pinned to a node, round-robin
+
+
+class ThreadPool;
+
+extern thread_local ThreadPool* local_pool; // The pool that this thread works for
+
+extern thread_local int local_worker_id; // The index of this thread's deque in the pool
+
+
+class ThreadPool
+{
+public:
+
+    using Work = std::function<void()>;
+
+    ThreadPool(int size) : size(size)
+    {
+        // Make the deques first, the workers steal each other's deque
+
+        for (int i = 0; i < size; i++)
+            deques.emplace_back(std::make_unique<WorkDeque<Work*>>());
+
+
+        // Make worker threads 
+
+        work_threads.reserve(size);
+
+        for (int i = 0; i < size; i++)
+            work_threads.emplace_back([this, i]() { this->DoWork(i); }); // Make thread instance that is doing Dowork()
+    }
+
+    ~ThreadPool()
+    {
+        // Set the stop flag and wake up all threads, so all threads can notice it
+
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+
+            stop = true;
+        }
+
+        cond.notify_all();
+
+        for (auto& thread : work_threads)
+            thread.join();
+
+
+        // Delete the works that are not done
+
+        Work* work;
+
+        for (auto& deque : deques)
+        {
+            while (deque->Pop(work))
+                delete work;
+        }
+
+        while (work_store >> work)
+            delete work;
+    }
+
+    // Request work to the thread pool
+    template <typename Function, typename... Args>
+    std::future<typename std::invoke_result<Function, Args...>::type> Request(Function&& f, Args&&... args)
+    {
+        using return_t = typename std::invoke_result<Function, Args...>::type; // invoke_result says function's return type
+
+        // Since these pointers are not used in here, make shared pointer to used at other working threads
+        // If shared pointer is not used, objects will be removed from stack. Then the work threads will not be able to use these objects
+
+        auto work = std::bind(std::forward<Function>(f), std::forward<Args>(args)...);
+
+        std::shared_ptr<std::packaged_task<return_t()>> pckg_work_ptr = std::make_shared<std::packaged_task<return_t()>>(work);
+
+
+        // Make future corresponding work promise
+
+        auto work_future = pckg_work_ptr->get_future();
+
+
+        // Make lambda function that copy shared pointers and execute the packaged work
+        // Then push it to the deque or work-store
+
+        Submit(new Work([this, pckg_work_ptr]() { (*pckg_work_ptr)(); Finished(); }));
+
+
+        // Return the futre corresponding new work
+
+        return std::move(work_future);
+    }
+
+    // The number of worker threads
+    int Size() const { return size; }
+
+    // Manage the task with threadpool's policy
+    template <typename ObjectType>
+    std::future<ObjectType>&& RequestWait(std::future<ObjectType>&& f)
+    {
+        Wait(f);
+
+        return std::move(f);
+    }
+
+    // Manage the task with threadpool's policy
+    template <typename ObjectType>
+    ObjectType RequestGet(std::future<ObjectType>&& f)
+    {
+        Wait(f);
+
+        return f.get();
+    }
+
+
+private:
+
+    // Push the work and wake up a parked worker
+    void Submit(Work* work)
+    {
+        // The worker of this pool pushes to its own deque
+
+        if (local_pool == this)
+            deques[local_worker_id]->Push(work);
+        else
+            work_store << work;
+
+
+        // Change the epoch, so the worker who is going to park can notice the new work
+        // Then wake up one if there is a parked worker
+
+        epoch.fetch_add(1);
+
+        if (sleepers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+
+            cond.notify_one();
+        }
+
+        // The parked waiters can help with the new work too
+
+        WakeWaiters();
+    }
+
+    // Change the epoch after a work is done, so the parked waiters check their futures again
+    void Finished()
+    {
+        epoch.fetch_add(1);
+
+        WakeWaiters();
+    }
+
+    // Wake up the parked waiters, if there are
+    void WakeWaiters()
+    {
+        if (waiters.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+
+            wait_cond.notify_all();
+        }
+    }
+
+    // Load the work for the worker
+    bool Load(int id, Work*& work)
+    {
+        // Own deque first
+
+        if (deques[id]->Pop(work))
+            return true;
+
+
+        // Then the works from outside
+
+        if (work_store >> work)
+            return true;
+
+
+        // Then steal from the others, start from the next of the last victim
+
+        for (int i = 1; i < size; i++)
+        {
+            int victim = (id + steal_offset + i) % size;
+
+            if (deques[victim]->Steal(work))
+            {
+                steal_offset = victim - id;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Whether there may be a work in the pool
+    bool HasWork()
+    {
+        if (!work_store.Empty())
+            return true;
+
+        for (auto& deque : deques)
+        {
+            if (!deque->Empty())
+                return true;
+        }
+
+        return false;
+    }
+
+    // Execute the work and delete it
+    static void Run(Work* work)
+    {
+        (*work)();
+
+        delete work;
+    }
+
+    // Wait the future
+    template <typename ObjectType>
+    void Wait(std::future<ObjectType>& f)
+    {
+        // If this thread is not the worker of this pool, just block
+
+        if (local_pool != this)
+        {
+            f.wait();
+
+            return;
+        }
+
+
+        // Otherwise, run the other works until the future is ready
+
+        Work* work;
+
+        while (!Ready(f))
+        {
+            if (Load(local_worker_id, work))
+            {
+                Run(work);
+
+                continue;
+            }
+
+
+            // There is no work, the awaited work is running on the other worker
+            // Park until a work is finished or pushed, the epoch is read before checking, so no change is missed
+
+            waiters.fetch_add(1);
+
+            uint64_t seen = epoch.load();
+
+            if (!Ready(f) && !HasWork())
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+
+                wait_cond.wait(lock, [this, seen]() { return epoch.load() != seen; });
+            }
+
+            waiters.fetch_sub(1);
+        }
+    }
+
+    // Whether the future is ready
+    template <typename ObjectType>
+    static bool Ready(std::future<ObjectType>& f)
+    {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // Worker thread's function
+    void DoWork(int id)
+    {
+        local_pool = this;
+
+        local_worker_id = id;
+
+#ifdef NUMA_MODE
+        Numa::PinThread(Numa::NodeOfWorker(id));
+#endif
+
+        Work* work;
+
+        while (true)
+        {
+            // Load the new work, if there is, do it
+
+            if (Load(id, work))
+            {
+                Run(work);
+
+                continue;
+            }
+
+
+            // Before parking, announce it and check the works again
+            // If a work is pushed after this check, the epoch will be different
+
+            sleepers.fetch_add(1);
+
+            uint64_t seen = epoch.load();
+
+            if (HasWork())
+            {
+                sleepers.fetch_sub(1);
+
+                continue;
+            }
+
+            bool stopped;
+
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+
+                cond.wait(lock, [this, seen]() { return stop || epoch.load() != seen; });
+
+                stopped = stop;
+            }
+
+            sleepers.fetch_sub(1);
+
+            if (stopped)
+                return;
+        }
+    }
+
+
+    int size = 0;
+
+    bool stop = false;
+
+    std::vector<std::thread> work_threads;
+
+    std::vector<std::unique_ptr<WorkDeque<Work*>>> deques;
+
+    WorkStore<Work*> work_store;
+
+    static thread_local int steal_offset;
+
+
+    // Parking
+
+    std::atomic<uint64_t> epoch = 0;
+
+    std::atomic<int> sleepers = 0;
+
+    std::mutex sleep_mutex;
+
+    std::condition_variable cond;
+
+
+    // The workers that wait their futures
+
+    std::atomic<int> waiters = 0;
+
+    std::condition_variable wait_cond;
+
+};
+
+#endif  // THREADPOOL_HPP
@@ -0,0 +1,20 @@
+#pragma once
+#include <fstream>
+#include "Relation.hpp"
+//---------------------------------------------------------------------------
+class Utils {
+ public:
+  /// Create a dummy relation
+  static Relation createRelation(uint64_t size,uint64_t numColumns);
+
+  /// The distribution of the values of a generated column
+  enum class Distribution { Sequential, Uniform, Zipf };
+
+  /// Create a relation whose columns have the values of the distribution, the same seed makes the same relation
+  /// A column has about size * (1 - duplicateRate) distinct values in [0, distinct), the zipf column may miss some rare ones
+  static Relation createRelation(uint64_t size,uint64_t numColumns,Distribution distribution,double duplicateRate,uint64_t seed);
+
+  /// Store a relation in all formats
+  static void storeRelation(std::ofstream& out,Relation& r,unsigned i);
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,231 @@
+#ifndef WORKSTORE_HPP
+#define WORKSTORE_HPP
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+
+// In this project, thread pool is used
+// The thread pool repeats saving and loading their works
+
+// These data structures are used for it
+
+// Each worker thread has its own WorkDeque (Chase-Lev work stealing deque)
+// The owner pushes and pops at the bottom without lock, and the other workers steal at the top
+// So most of works are stored and loaded by the thread that made them, without touching the shared memory
+
+// The works which are made outside of the pool are stored to the WorkStore,
+// then the workers load them from it
+
+
+template <typename WorkType>
+class WorkDeque
+{
+public:
+
+  WorkDeque(int64_t capacity = 1024) : array(new Array(capacity)) {}
+
+  ~WorkDeque()
+  {
+    delete array.load();
+
+    for (auto a : garbage)
+      delete a;
+  }
+
+  WorkDeque(const WorkDeque&) = delete;
+
+  WorkDeque& operator=(const WorkDeque&) = delete;
+
+  // Push the work at the bottom, only the owner can call it
+  void Push(WorkType work)
+  {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+
+    int64_t t = top.load(std::memory_order_acquire);
+
+    Array* a = array.load(std::memory_order_relaxed);
+
+
+    // If the array is full, make the new one that is two times larger
+
+    if (b - t > a->capacity - 1)
+      a = Grow(a, b, t);
+
+    a->Put(b, work);
+
+    bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // Pop the work at the bottom, only the owner can call it
+  bool Pop(WorkType& work)
+  {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+
+    Array* a = array.load(std::memory_order_relaxed);
+
+    bottom.store(b, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t t = top.load(std::memory_order_relaxed);
+
+
+    // The deque was empty
+
+    if (t > b)
+    {
+      bottom.store(b + 1, std::memory_order_relaxed);
+
+      return false;
+    }
+
+    work = a->Get(b);
+
+
+    // If this is the last work, race with the stealers for it
+
+    if (t == b)
+    {
+      bool success = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+      bottom.store(b + 1, std::memory_order_relaxed);
+
+      return success;
+    }
+
+    return true;
+  }
+
+  // Steal the work at the top, any thread can call it
+  bool Steal(WorkType& work)
+  {
+    int64_t t = top.load(std::memory_order_acquire);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+      return false;
+
+    Array* a = array.load(std::memory_order_acquire);
+
+    work = a->Get(t);
+
+
+    // If the other thread took it first, fail
+
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  // Whether there may be a work to steal
+  bool Empty() const
+  {
+    return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+  }
+
+private:
+
+  // Circular array of the works
+  struct Array
+  {
+    Array(int64_t capacity) : capacity(capacity), mask(capacity - 1), buffer(new std::atomic<WorkType>[capacity]) {}
+
+    ~Array() { delete[] buffer; }
+
+    WorkType Get(int64_t i) const { return buffer[i & mask].load(std::memory_order_relaxed); }
+
+    void Put(int64_t i, WorkType work) { buffer[i & mask].store(work, std::memory_order_relaxed); }
+
+    int64_t capacity;
+
+    int64_t mask;
+
+    std::atomic<WorkType>* buffer;
+  };
+
+  // Copy the works to the larger array
+  // The old array can still be read by the stealers, so keep it until the destructor
+  Array* Grow(Array* a, int64_t b, int64_t t)
+  {
+    Array* grown = new Array(a->capacity * 2);
+
+    for (int64_t i = t; i < b; i++)
+      grown->Put(i, a->Get(i));
+
+    garbage.push_back(a);
+
+    array.store(grown, std::memory_order_release);
+
+    return grown;
+  }
+
+
+  alignas(64) std::atomic<int64_t> top = 0;
+
+  alignas(64) std::atomic<int64_t> bottom = 0;
+
+  std::atomic<Array*> array;
+
+  std::vector<Array*> garbage;
+
+};
+
+template <typename WorkType>
+class WorkStore
+{
+public:
+
+  // Loading
+  bool operator>>(WorkType& work)
+  {
+    // Check the count first, so the idle workers do not contend on the mutex
+
+    if (count.load(std::memory_order_acquire) == 0)
+      return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (works.empty())
+      return false;
+
+    work = std::move(works.front());
+
+    works.pop_front();
+
+    count.fetch_sub(1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Saving
+  void operator<<(WorkType work)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    works.push_back(std::move(work));
+
+    count.fetch_add(1, std::memory_order_release);
+  }
+
+  // Whether there may be a work to load
+  bool Empty() const
+  {
+    return count.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+
+  std::deque<WorkType> works;
+
+  std::atomic<uint64_t> count = 0;
+
+  std::mutex mutex;
+
+};
+
+#endif  // WORKSTORE_HPP
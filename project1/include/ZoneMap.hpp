@@ -0,0 +1,73 @@
+#ifndef ZONEMAP_HPP
+#define ZONEMAP_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "Statistics.hpp"
+
+
+constexpr uint64_t ZONE_SIZE = 1 << 14;  // The tuples of a zone
+
+
+// Zone map of a column, the smallest and the largest values of each zone of ZONE_SIZE tuples
+// A scan can skip the zone whose range can not satisfy its filter, or take the whole zone without testing
+
+
+class ZoneMap
+{
+public:
+
+  /// The smallest values of the zones
+  std::vector<uint64_t> mins;
+
+  /// The largest values of the zones
+  std::vector<uint64_t> maxs;
+
+  /// Make the zones for the tuples
+  void Resize(uint64_t size)
+  {
+    mins.resize((size + ZONE_SIZE - 1) / ZONE_SIZE);
+
+    maxs.resize(mins.size());
+  }
+
+  /// Build the zones of col[start, end), the start is the first tuple of a zone
+  void Build(const uint64_t* col, uint64_t start, uint64_t end)
+  {
+    for (uint64_t zoneStart = start; zoneStart < end; zoneStart += ZONE_SIZE)
+    {
+      uint64_t zoneEnd = zoneStart + ZONE_SIZE < end ? zoneStart + ZONE_SIZE : end;
+
+      uint64_t min = col[zoneStart], max = col[zoneStart];
+
+      for (uint64_t i = zoneStart; i < zoneEnd; i++)
+      {
+        min = min < col[i] ? min : col[i];
+
+        max = max > col[i] ? max : col[i];
+      }
+
+      mins[zoneStart / ZONE_SIZE] = min;
+
+      maxs[zoneStart / ZONE_SIZE] = max;
+    }
+  }
+
+  /// Store to the statistics file
+  void Save(StatisticsWriter& writer) const
+  {
+    writer.Write(mins);
+
+    writer.Write(maxs);
+  }
+
+  /// Load from the statistics file
+  bool Load(StatisticsReader& reader)
+  {
+    return reader.Read(mins) && reader.Read(maxs) && mins.size() == maxs.size();
+  }
+
+};
+
+#endif  // ZONEMAP_HPP
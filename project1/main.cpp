@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <fstream>
+
+#include "Joiner.hpp"
+#include "Parser.hpp"
+#include "Threadpool.hpp"
+#include "Executeoptions.hpp"
+
+
+using namespace std;
+
+
+#ifdef MULTI_THREAD_MODE
+// One worker per core, a waiting worker runs the other works instead of blocking
+ThreadPool threadpool(std::max(std::thread::hardware_concurrency(), 1u));
+#endif
+std::atomic<int> timecount = 0;
+
+int main(int argc, char* argv[]) 
+{
+   Joiner joiner;
+   
+   
+   // Read join relations, then load them at once
+   
+   string line;
+
+   vector<string> fileNames;
+   
+   while (getline(cin, line)) 
+   {
+      if (line == "Done") break;
+      
+      fileNames.push_back(line);
+   }
+
+   joiner.addRelations(fileNames);
+
+
+   // Preparation phase (not timed)
+   // Build histograms, then the hash indexes of the key-like columns
+#ifdef QUERY_OPTIMIZE_MODE
+#ifdef SINGLE_THREAD_MODE
+   for (size_t i = 0; i < joiner.relations.size(); i++)
+   {
+      joiner.relations[i].BuildHistogram(); 
+
+#ifdef INDEX_JOIN_MODE
+      joiner.relations[i].BuildIndexes();
+#endif
+   }
+#endif
+#ifdef MULTI_THREAD_MODE
+   std::vector<std::future<void>> bulid_histograms;
+
+   for (size_t i = 0; i < joiner.relations.size(); i++)
+   {
+      bulid_histograms.push_back(std::move(threadpool.Request([&joiner, i]() mutable 
+                                                              { 
+                                                                 joiner.relations[i].BuildHistogram(); 
+#ifdef INDEX_JOIN_MODE
+                                                                 joiner.relations[i].BuildIndexes();
+#endif
+                                                              })));
+   }
+
+   for (int i = 0; i < bulid_histograms.size(); i++)
+   {
+      bulid_histograms[i].wait();
+   }
+#endif
+#endif
+
+
+#ifdef SINGLE_THREAD_MODE
+   QueryInfo i;
+#endif
+#ifdef MULTI_THREAD_MODE
+#ifdef SHARED_SUBPLAN_MODE
+   std::vector<QueryInfo> batch;
+#else
+   std::vector<std::future<string>> results;
+#endif
+#endif
+
+   
+   while (getline(cin, line)) 
+   {
+      if (line == "F")
+      {
+#ifdef MULTI_THREAD_MODE
+#ifdef SHARED_SUBPLAN_MODE
+        // The queries of the batch are optimized together, so their common subplans are done once
+
+        for (auto& result : joiner.joinBatch(batch))
+        {
+            std::cout << result;
+        }
+
+        batch.clear();
+#else
+        for (int i = 0; i < results.size(); i++)
+        {
+            std::cout << results[i].get();
+        }
+
+        results.clear();
+#endif
+#endif
+        continue;
+      }
+
+#ifdef SINGLE_THREAD_MODE
+      i.parseQuery(line);
+
+      cout << joiner.join(i);
+#endif
+#ifdef MULTI_THREAD_MODE
+#ifdef SHARED_SUBPLAN_MODE
+      batch.emplace_back();
+
+      batch.back().parseQuery(line);
+#else
+      results.push_back(std::move(threadpool.Request([&joiner, line]() mutable { QueryInfo i; i.parseQuery(line); return joiner.join(i); })));
+#endif
+#endif
+   }
+
+   std::cerr << timecount << std::endl;
+   
+   return 0;
+}